@@ -0,0 +1,676 @@
+/*  File: Benchmark.cpp
+ *  This file contains driver code that times the BinarySearchTree class on
+ *  larger workloads than the MinimumDepth.cpp example, so that changes to the
+ *  implementation can be compared by running it before and after.
+ *
+ *  Compile with -std=c++11 -O2 -pthread.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "BinarySearchTree.h"
+#include "RadixTree.h"
+#include "TreeDumper.h"
+
+using namespace std;
+
+// Function elapsedNanoseconds
+// Input: start - A time point taken before the timed work.
+// Output: The number of nanoseconds that have passed since start.
+double elapsedNanoseconds(chrono::steady_clock::time_point start)
+{
+    chrono::steady_clock::time_point end = chrono::steady_clock::now();
+    return chrono::duration<double, nano>(end - start).count();
+}
+
+// Function reportResult
+// Input: name - A short description of the workload.
+//        operations - The number of tree operations performed.
+//        nanoseconds - The total time the operations took.
+// Output: Prints one line with the time per operation and the throughput.
+void reportResult(const char *name, size_t operations, double nanoseconds)
+{
+    cout << name << ": " << nanoseconds / operations << " ns/op, "
+         << operations / (nanoseconds / 1e9) / 1e6 << " Mops/s" << endl;
+}
+
+// Function benchmarkChurn
+// Input: keyCount - The number of keys the tree holds in steady state.
+//        rounds - How many times each key is removed and re-inserted.
+// Output: Prints the cost of inserting and removing keys from a tree that
+//          keeps a constant size, the workload that used to be dominated by
+//          new and delete.
+void benchmarkChurn(size_t keyCount, size_t rounds)
+{
+    mt19937 generator(12345);
+    uniform_int_distribution<int> distribution;
+    vector<int> keys(keyCount);
+
+    for (size_t i = 0; i < keyCount; ++i)
+    {
+        keys[i] = distribution(generator);
+    }
+
+    BinarySearchTree binarySearchTree;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    for (size_t i = 0; i < keyCount; ++i)
+    {
+        binarySearchTree.insertNode(keys[i]);
+    }
+
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        for (size_t i = 0; i < keyCount; ++i)
+        {
+            binarySearchTree.removeNode(keys[i]);
+            keys[i] = distribution(generator);
+            binarySearchTree.insertNode(keys[i]);
+        }
+    }
+
+    binarySearchTree.destroyBinarySearchTree();
+
+    cout << keyCount << " keys, ";
+    reportResult("insert/remove churn", keyCount * (1 + 2 * rounds),
+                 elapsedNanoseconds(start));
+}
+
+// Function benchmarkLookups
+// Input: keyCount - The number of keys in the tree.
+//        lookups - The number of searches to time.
+// Output: Prints the cost of containsNode on the pointer-based tree and on a
+//          FrozenBinarySearchTree snapshot of it, for a mix of present and
+//          absent keys.
+void benchmarkLookups(size_t keyCount, size_t lookups)
+{
+    mt19937 generator(54321);
+    uniform_int_distribution<int> distribution(0, 2 * keyCount);
+    BinarySearchTree binarySearchTree;
+    FrozenBinarySearchTree<int> snapshot;
+    vector<int> probes(lookups);
+    size_t found = 0;
+
+    for (size_t i = 0; i < keyCount; ++i)
+    {
+        binarySearchTree.insertNode(distribution(generator));
+    }
+
+    for (size_t i = 0; i < lookups; ++i)
+    {
+        probes[i] = distribution(generator);
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    binarySearchTree.freeze(snapshot);
+    cout << keyCount << " keys, freeze: "
+         << elapsedNanoseconds(start) / 1e6 << " ms" << endl;
+
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i)
+    {
+        found += binarySearchTree.containsNode(probes[i]);
+    }
+    cout << keyCount << " keys, ";
+    reportResult("containsNode", lookups, elapsedNanoseconds(start));
+
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i)
+    {
+        found -= snapshot.containsNode(probes[i]);
+    }
+    cout << keyCount << " keys, ";
+    reportResult("frozen containsNode", lookups, elapsedNanoseconds(start));
+
+    // Both loops must agree, and using the count keeps them from being
+    // optimized away:
+    if (found != 0)
+    {
+        cout << "Snapshot and tree disagree!" << endl;
+    }
+}
+
+// Function benchmarkBulkLoad
+// Input: keyCount - The number of sorted keys to load.
+// Output: Prints the cost of loading sorted keys one insertNode at a time and
+//          with buildFromSortedKeys.
+void benchmarkBulkLoad(size_t keyCount)
+{
+    vector<int> keys(keyCount);
+    BinarySearchTree binarySearchTree;
+
+    for (size_t i = 0; i < keyCount; ++i)
+    {
+        keys[i] = static_cast<int>(2 * i);
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keyCount; ++i)
+    {
+        binarySearchTree.insertNode(keys[i]);
+    }
+    cout << keyCount << " keys, ";
+    reportResult("sorted insertNode", keyCount, elapsedNanoseconds(start));
+
+    start = chrono::steady_clock::now();
+    binarySearchTree.buildFromSortedKeys(&keys[0], keyCount);
+    cout << keyCount << " keys, ";
+    reportResult("buildFromSortedKeys", keyCount, elapsedNanoseconds(start));
+}
+
+// Function benchmarkBatchLookups
+// Input: keyCount - The number of keys in the tree.
+//        lookups - The number of searches to time.
+// Output: Prints the cost per key of a loop of containsNode calls and of one
+//          containsNodes call over the same keys.
+void benchmarkBatchLookups(size_t keyCount, size_t lookups)
+{
+    mt19937 generator(98765);
+    uniform_int_distribution<int> distribution(0, 2 * keyCount);
+    BinarySearchTree binarySearchTree;
+    vector<int> probes(lookups);
+    bool *found = new bool[lookups];
+    size_t mismatches = 0;
+
+    for (size_t i = 0; i < keyCount; ++i)
+    {
+        binarySearchTree.insertNode(distribution(generator));
+    }
+
+    for (size_t i = 0; i < lookups; ++i)
+    {
+        probes[i] = distribution(generator);
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i)
+    {
+        found[i] = binarySearchTree.containsNode(probes[i]);
+    }
+    cout << keyCount << " keys, ";
+    reportResult("containsNode loop", lookups, elapsedNanoseconds(start));
+
+    vector<bool> expected(found, found + lookups);
+
+    start = chrono::steady_clock::now();
+    binarySearchTree.containsNodes(&probes[0], lookups, found);
+    cout << keyCount << " keys, ";
+    reportResult("containsNodes batch", lookups, elapsedNanoseconds(start));
+
+    for (size_t i = 0; i < lookups; ++i)
+    {
+        mismatches += (found[i] != expected[i]);
+    }
+
+    if (mismatches != 0)
+    {
+        cout << "Batch and single lookups disagree!" << endl;
+    }
+
+    delete [] found;
+}
+
+// Function benchmarkDump
+// Input: keyCount - The number of keys in the tree.
+// Output: Prints the cost per key of writing the keys breadth-first to
+//          /dev/null one at a time through an ofstream, the way
+//          printBinarySearchTree used to, and with a TreeDumper as text and
+//          as binary.
+void benchmarkDump(size_t keyCount)
+{
+    mt19937 generator(24680);
+    uniform_int_distribution<int> distribution;
+    vector<int> keys(keyCount);
+    BinarySearchTree binarySearchTree;
+
+    for (size_t i = 0; i < keyCount; ++i)
+    {
+        keys[i] = distribution(generator);
+    }
+
+    binarySearchTree.buildFromKeys(&keys[0], keyCount);
+
+    ofstream stream("/dev/null");
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    binarySearchTree.visit(BREADTH_FIRST, [&stream](const int &key, int)
+    {
+        stream << key << " ";
+    });
+    stream.flush();
+    cout << keyCount << " keys, ";
+    reportResult("ofstream text dump", keyCount, elapsedNanoseconds(start));
+
+    FILE *output = fopen("/dev/null", "wb");
+    TreeDumper dumper(output);
+
+    start = chrono::steady_clock::now();
+    dumper.dumpText(binarySearchTree, BREADTH_FIRST, ' ');
+    cout << keyCount << " keys, ";
+    reportResult("TreeDumper text dump", keyCount, elapsedNanoseconds(start));
+
+    start = chrono::steady_clock::now();
+    dumper.dumpBinary(binarySearchTree, BREADTH_FIRST);
+    cout << keyCount << " keys, ";
+    reportResult("TreeDumper binary dump", keyCount,
+                 elapsedNanoseconds(start));
+
+    start = chrono::steady_clock::now();
+    dumper.dumpBinary(binarySearchTree, IN_ORDER);
+    cout << keyCount << " keys, ";
+    reportResult("TreeDumper in-order binary dump", keyCount,
+                 elapsedNanoseconds(start));
+
+    fclose(output);
+}
+
+// Function benchmarkSnapshot
+// Input: keyCount - The number of keys in the tree.
+// Output: Prints the time to get a searchable set of keys at startup by
+//          replaying insertNode calls and by mapping a saved snapshot, with
+//          and without checking its checksum, then the cost of searching the
+//          mapped snapshot. The snapshot file is removed afterwards.
+void benchmarkSnapshot(size_t keyCount)
+{
+    const char *PATH = "Benchmark.snapshot";
+    mt19937 generator(13579);
+    uniform_int_distribution<int> distribution;
+    vector<int> keys(keyCount);
+    BinarySearchTree binarySearchTree;
+
+    for (size_t i = 0; i < keyCount; ++i)
+    {
+        keys[i] = distribution(generator);
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keyCount; ++i)
+    {
+        binarySearchTree.insertNode(keys[i]);
+    }
+    cout << keyCount << " keys, replaying insertNode: "
+         << elapsedNanoseconds(start) / 1e6 << " ms" << endl;
+
+    start = chrono::steady_clock::now();
+    if (!binarySearchTree.save(PATH))
+    {
+        cout << "Could not save the snapshot!" << endl;
+        return;
+    }
+    cout << keyCount << " keys, save: " << elapsedNanoseconds(start) / 1e6
+         << " ms" << endl;
+
+    FrozenBinarySearchTree<int> snapshot;
+
+    start = chrono::steady_clock::now();
+    snapshot.loadMapped(PATH);
+    cout << keyCount << " keys, loadMapped with checksum: "
+         << elapsedNanoseconds(start) / 1e6 << " ms" << endl;
+
+    start = chrono::steady_clock::now();
+    snapshot.loadMapped(PATH, false);
+    cout << keyCount << " keys, loadMapped without checksum: "
+         << elapsedNanoseconds(start) / 1e6 << " ms" << endl;
+
+    size_t found = 0;
+
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keyCount; ++i)
+    {
+        found += snapshot.containsNode(keys[i]);
+    }
+    cout << keyCount << " keys, ";
+    reportResult("mapped snapshot containsNode", keyCount,
+                 elapsedNanoseconds(start));
+
+    if (found != keyCount)
+    {
+        cout << "Mapped snapshot is missing keys!" << endl;
+    }
+
+    remove(PATH);
+}
+
+// Function benchmarkSetOperations
+// Input: keyCount - The number of keys in the larger tree.
+//        otherCount - The number of keys in the smaller tree.
+// Output: Prints the time of unionWith, intersectWith and differenceWith,
+//          and of doing the same one key at a time by walking the smaller
+//          tree and calling insertNode or removeNode on the larger one.
+void benchmarkSetOperations(size_t keyCount, size_t otherCount)
+{
+    mt19937 generator(11235);
+    uniform_int_distribution<int> distribution(0, 4 * keyCount);
+    vector<int> keys(keyCount);
+    BinarySearchTree other;
+    BinarySearchTree binarySearchTree;
+
+    // About half of the other tree's keys are also in the larger tree:
+    for (size_t i = 0; i < keyCount; ++i)
+    {
+        keys[i] = static_cast<int>(2 * i);
+    }
+
+    while (other.size() < otherCount)
+    {
+        other.insertNode(distribution(generator));
+    }
+
+    const char *NAMES[] = { "union", "intersection", "difference" };
+
+    for (int operation = 0; operation < 3; ++operation)
+    {
+        binarySearchTree.buildFromSortedKeys(&keys[0], keyCount);
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        if (operation == 0)
+        {
+            binarySearchTree.unionWith(other);
+        }
+        else if (operation == 1)
+        {
+            binarySearchTree.intersectWith(other);
+        }
+        else
+        {
+            binarySearchTree.differenceWith(other);
+        }
+        double joined = elapsedNanoseconds(start);
+        size_t joinedSize = binarySearchTree.size();
+
+        binarySearchTree.buildFromSortedKeys(&keys[0], keyCount);
+
+        size_t singleSize = 0;
+
+        start = chrono::steady_clock::now();
+        if (operation == 0)
+        {
+            for (BinarySearchTree::iterator it = other.begin();
+                 it != other.end(); ++it)
+            {
+                binarySearchTree.insertNode(*it);
+            }
+        }
+        else if (operation == 1)
+        {
+            BinarySearchTree result;
+
+            for (BinarySearchTree::iterator it = other.begin();
+                 it != other.end(); ++it)
+            {
+                if (binarySearchTree.containsNode(*it))
+                {
+                    result.insertNode(*it);
+                }
+            }
+
+            binarySearchTree.destroyBinarySearchTree();
+            singleSize = result.size();
+        }
+        else
+        {
+            for (BinarySearchTree::iterator it = other.begin();
+                 it != other.end(); ++it)
+            {
+                binarySearchTree.removeNode(*it);
+            }
+        }
+        double single = elapsedNanoseconds(start);
+
+        if (operation != 1)
+        {
+            singleSize = binarySearchTree.size();
+        }
+
+        if (joinedSize != singleSize)
+        {
+            cout << "Set operation and single updates disagree!" << endl;
+        }
+
+        cout << keyCount << " and " << otherCount << " keys, "
+             << NAMES[operation] << ": split/join " << joined / 1e6
+             << " ms, one key at a time " << single / 1e6 << " ms" << endl;
+    }
+}
+
+// Function runMixedWorkload
+// Input: tree - An empty tree of any statistics policy.
+//        keys - Keys to insert, then remove and re-insert once each.
+//        probes - Keys to look up in between.
+// Output: Returns the nanoseconds the whole workload took.
+template <class Tree>
+double runMixedWorkload(Tree &tree, const vector<int> &keys,
+                        const vector<int> &probes)
+{
+    size_t found = 0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        tree.insertNode(keys[i]);
+    }
+
+    for (size_t i = 0; i < probes.size(); ++i)
+    {
+        found += tree.containsNode(probes[i]);
+    }
+
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        tree.removeNode(keys[i]);
+        tree.insertNode(keys[i]);
+    }
+
+    double nanoseconds = elapsedNanoseconds(start);
+
+    // Using the count keeps the lookups from being optimized away:
+    if (found > probes.size())
+    {
+        cout << "Found more keys than were looked up!" << endl;
+    }
+
+    return nanoseconds;
+}
+
+// Function benchmarkStatistics
+// Input: keyCount - The number of keys in the tree.
+//        lookups - The number of searches in the workload.
+// Output: Prints the time of the same workload on a BinarySearchTree and on
+//          an InstrumentedBinarySearchTree, and what the latter recorded.
+void benchmarkStatistics(size_t keyCount, size_t lookups)
+{
+    mt19937 generator(31415);
+    uniform_int_distribution<int> distribution(0, 2 * keyCount);
+    vector<int> keys(keyCount);
+    vector<int> probes(lookups);
+    BinarySearchTree binarySearchTree;
+    InstrumentedBinarySearchTree instrumentedTree;
+
+    for (size_t i = 0; i < keyCount; ++i)
+    {
+        keys[i] = distribution(generator);
+    }
+
+    for (size_t i = 0; i < lookups; ++i)
+    {
+        probes[i] = distribution(generator);
+    }
+
+    size_t operations = 3 * keyCount + lookups;
+    double plain = runMixedWorkload(binarySearchTree, keys, probes);
+    double instrumented = runMixedWorkload(instrumentedTree, keys, probes);
+
+    cout << keyCount << " keys, ";
+    reportResult("mixed workload", operations, plain);
+    cout << keyCount << " keys, ";
+    reportResult("mixed workload with statistics", operations, instrumented);
+
+    TreeStatisticsSnapshot counts = instrumentedTree.statistics();
+
+    cout << keyCount << " keys, path lengths (mean/99th percentile): search "
+         << TreeStatisticsSnapshot::mean(counts.searchLengths) << "/"
+         << TreeStatisticsSnapshot::percentile(counts.searchLengths, 0.99)
+         << ", insertion "
+         << TreeStatisticsSnapshot::mean(counts.insertionLengths) << "/"
+         << TreeStatisticsSnapshot::percentile(counts.insertionLengths, 0.99)
+         << ", removal "
+         << TreeStatisticsSnapshot::mean(counts.removalLengths) << "/"
+         << TreeStatisticsSnapshot::percentile(counts.removalLengths, 0.99)
+         << endl;
+    cout << keyCount << " keys, " << counts.successorReplacements
+         << " successor replacements, " << counts.nodeAllocations
+         << " nodes allocated, " << counts.nodeFrees << " freed" << endl;
+}
+
+// Function runOrderedSetWorkload
+// Input: set - An empty BinarySearchTree or RadixTree.
+//        keys - The keys to insert and, at the end, remove.
+//        probes - Keys to look up, and to find the successors of.
+//        nanoseconds - Filled with the time taken by insertNode,
+//                      containsNode, successor and removeNode, in order.
+// Output: Returns a checksum of the answers, which must not depend on set.
+template <class OrderedSet>
+size_t runOrderedSetWorkload(OrderedSet &set, const vector<int> &keys,
+                             const vector<int> &probes, double nanoseconds[4])
+{
+    size_t checksum = 0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        set.insertNode(keys[i]);
+    }
+    nanoseconds[0] = elapsedNanoseconds(start);
+
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < probes.size(); ++i)
+    {
+        checksum += set.containsNode(probes[i]);
+    }
+    nanoseconds[1] = elapsedNanoseconds(start);
+
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < probes.size(); ++i)
+    {
+        int next = 0;
+
+        if (set.successor(probes[i], next))
+        {
+            checksum += static_cast<unsigned>(next);
+        }
+    }
+    nanoseconds[2] = elapsedNanoseconds(start);
+
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        set.removeNode(keys[i]);
+    }
+    nanoseconds[3] = elapsedNanoseconds(start);
+
+    return checksum;
+}
+
+// Function benchmarkRadixTree
+// Input: keyCount - The number of keys to insert.
+//        dense - Whether the keys are 0 to keyCount - 1, like IDs handed out
+//                in order, or drawn from the whole int range.
+//        lookups - The number of searches to time.
+// Output: Prints the cost of each operation on a BinarySearchTree and on a
+//          RadixTree holding the same keys. Keys are inserted in random
+//          order, and half of the searched keys are absent.
+void benchmarkRadixTree(size_t keyCount, bool dense, size_t lookups)
+{
+    mt19937 generator(27182);
+    vector<int> keys(keyCount);
+    vector<int> probes(lookups);
+
+    if (dense)
+    {
+        for (size_t i = 0; i < keyCount; ++i)
+        {
+            keys[i] = static_cast<int>(i);
+        }
+
+        shuffle(keys.begin(), keys.end(), generator);
+    }
+    else
+    {
+        uniform_int_distribution<int> distribution;
+
+        for (size_t i = 0; i < keyCount; ++i)
+        {
+            keys[i] = distribution(generator);
+        }
+    }
+
+    uniform_int_distribution<size_t> position(0, keyCount - 1);
+
+    for (size_t i = 0; i < lookups; ++i)
+    {
+        // Odd probes of dense keys are past the end, and those of sparse
+        // keys almost never hit:
+        int key = keys[position(generator)];
+
+        probes[i] = (i % 2 == 0 ? key : dense ? key + int(keyCount) : ~key);
+    }
+
+    BinarySearchTree binarySearchTree;
+    RadixTree radixTree;
+    double treeNanoseconds[4];
+    double radixNanoseconds[4];
+    const char *NAMES[] = { "insertNode", "containsNode", "successor",
+                            "removeNode" };
+    size_t counts[] = { keyCount, lookups, lookups, keyCount };
+
+    size_t treeChecksum = runOrderedSetWorkload(binarySearchTree, keys,
+                                                probes, treeNanoseconds);
+    size_t radixChecksum = runOrderedSetWorkload(radixTree, keys, probes,
+                                                 radixNanoseconds);
+
+    if (treeChecksum != radixChecksum)
+    {
+        cout << "Radix tree and binary search tree disagree!" << endl;
+    }
+
+    for (int operation = 0; operation < 4; ++operation)
+    {
+        cout << keyCount << (dense ? " dense" : " sparse") << " keys, "
+             << NAMES[operation] << ": tree "
+             << treeNanoseconds[operation] / counts[operation]
+             << " ns/op, radix "
+             << radixNanoseconds[operation] / counts[operation] << " ns/op"
+             << endl;
+    }
+}
+
+int main()
+{
+    benchmarkChurn(10000, 200);
+    benchmarkChurn(1000000, 4);
+    benchmarkLookups(10000, 10000000);
+    benchmarkLookups(4000000, 10000000);
+    benchmarkBulkLoad(4000000);
+    benchmarkBatchLookups(10000, 10000000);
+    benchmarkBatchLookups(4000000, 10000000);
+    benchmarkDump(10000000);
+    benchmarkSnapshot(4000000);
+    benchmarkSetOperations(4000000, 1000);
+    benchmarkSetOperations(4000000, 100000);
+    benchmarkSetOperations(4000000, 4000000);
+    benchmarkStatistics(10000, 10000000);
+    benchmarkStatistics(4000000, 10000000);
+    benchmarkRadixTree(10000, true, 10000000);
+    benchmarkRadixTree(4000000, true, 10000000);
+    benchmarkRadixTree(10000, false, 10000000);
+    benchmarkRadixTree(4000000, false, 10000000);
+
+    return 0;
+}
@@ -0,0 +1,321 @@
+/*  File: BenchmarkSuite.cpp
+ *  This file contains a benchmark suite for the BinarySearchTree class, meant
+ *  to be run before and after a change so that performance regressions show
+ *  up. Every combination of a key stream and a tree size is measured:
+ *  (a) sorted: 0, 1, 2, ...
+ *  (b) reverse: the same keys from the largest down,
+ *  (c) uniform: keys drawn uniformly from the whole int range,
+ *  (d) zipf: keys drawn from as many distinct keys as the tree size, with
+ *      Zipf-distributed popularity (exponent 0.99), so a few keys repeat
+ *      often and the tree ends up with fewer keys than the stream.
+ *  The default sizes range from a tree that fits in the L1 cache to one far
+ *  larger than the last level cache; other sizes can be given as arguments.
+ *
+ *  For each stream and size the keys are inserted into an empty tree, looked
+ *  up again in stream order with containsNode, minimumDepth is polled, the
+ *  keys are removed in stream order, and finally the tree is refilled and
+ *  destroyed. Small trees repeat this until enough operations have been
+ *  timed. Each combination runs in a child process of its own, so the peak
+ *  resident set size reported is that of the combination alone.
+ *
+ *  The output is CSV on stdout, one line per operation, with the columns
+ *  listed in the first line, so results from two commits can be compared
+ *  with standard tools.
+ *
+ *  Usage: BenchmarkSuite [size ...]
+ *  Compile with -std=c++11 -O2. Needs a POSIX system.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include "BinarySearchTree.h"
+
+using namespace std;
+
+// Small trees repeat their workload until at least this many operations of
+// each kind have been timed:
+const size_t MIN_OPERATIONS = 2000000;
+
+// Data Structure: KeyStream
+// The kinds of key stream measured.
+enum KeyStream
+{
+    SORTED,
+    REVERSE,
+    UNIFORM,
+    ZIPF
+};
+
+const char *STREAM_NAMES[] = { "sorted", "reverse", "uniform", "zipf" };
+
+// Data Structure: Timings
+// The total time spent on each kind of operation, and how many were done.
+struct Timings
+{
+    double insertNanoseconds;
+    double containsNanoseconds;
+    double minimumDepthNanoseconds;
+    double removeNanoseconds;
+    double destroyNanoseconds;
+    size_t operations;
+};
+
+// Function elapsedNanoseconds
+// Input: start - A time point taken before the timed work.
+// Output: The number of nanoseconds that have passed since start.
+double elapsedNanoseconds(chrono::steady_clock::time_point start)
+{
+    chrono::steady_clock::time_point end = chrono::steady_clock::now();
+    return chrono::duration<double, nano>(end - start).count();
+}
+
+// Function makeKeys
+// Input: stream - The kind of key stream to generate.
+//        count - The number of keys in the stream.
+// Output: Returns the keys, in the order they are to be inserted.
+vector<int> makeKeys(KeyStream stream, size_t count)
+{
+    mt19937 generator(2718281);
+    vector<int> keys(count);
+
+    if (stream == SORTED || stream == REVERSE)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            keys[i] = static_cast<int>(stream == SORTED ? i : count - 1 - i);
+        }
+    }
+    else if (stream == UNIFORM)
+    {
+        uniform_int_distribution<int> distribution;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            keys[i] = distribution(generator);
+        }
+    }
+    else
+    {
+        // The cumulative popularity of the ranks, searched with a uniform
+        // draw to pick a rank:
+        vector<double> cumulative(count);
+        double total = 0;
+
+        for (size_t rank = 0; rank < count; ++rank)
+        {
+            total += 1.0 / pow(static_cast<double>(rank + 1), 0.99);
+            cumulative[rank] = total;
+        }
+
+        uniform_real_distribution<double> distribution(0, total);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            size_t rank = upper_bound(cumulative.begin(), cumulative.end(),
+                                      distribution(generator)) -
+                          cumulative.begin();
+
+            rank = min(rank, count - 1);
+
+            // Multiplying by an odd constant scatters the popular ranks over
+            // the key space instead of keeping them next to each other:
+            keys[i] = static_cast<int>(static_cast<uint32_t>(rank) *
+                                       2654435761u);
+        }
+    }
+
+    return keys;
+}
+
+// Function runWorkload
+// Input: keys - The key stream.
+//        timings - Filled with the time spent on each kind of operation.
+//        height - Set to the height of the tree once all keys are in.
+//        distinctKeys - Set to the number of keys in the full tree.
+// Output: None.
+void runWorkload(const vector<int> &keys, Timings &timings, int &height,
+                 size_t &distinctKeys)
+{
+    size_t count = keys.size();
+    size_t rounds = max<size_t>(1, MIN_OPERATIONS / count);
+    BinarySearchTree binarySearchTree;
+    size_t found = 0;
+    int depths = 0;
+
+    timings.insertNanoseconds = 0;
+    timings.containsNanoseconds = 0;
+    timings.minimumDepthNanoseconds = 0;
+    timings.removeNanoseconds = 0;
+    timings.destroyNanoseconds = 0;
+    timings.operations = rounds * count;
+
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i)
+        {
+            binarySearchTree.insertNode(keys[i]);
+        }
+        timings.insertNanoseconds += elapsedNanoseconds(start);
+
+        height = binarySearchTree.maximumDepth();
+        distinctKeys = binarySearchTree.size();
+
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i)
+        {
+            found += binarySearchTree.containsNode(keys[i]);
+        }
+        timings.containsNanoseconds += elapsedNanoseconds(start);
+
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i)
+        {
+            depths += binarySearchTree.minimumDepth();
+        }
+        timings.minimumDepthNanoseconds += elapsedNanoseconds(start);
+
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i)
+        {
+            binarySearchTree.removeNode(keys[i]);
+        }
+        timings.removeNanoseconds += elapsedNanoseconds(start);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            binarySearchTree.insertNode(keys[i]);
+        }
+
+        start = chrono::steady_clock::now();
+        binarySearchTree.destroyBinarySearchTree();
+        timings.destroyNanoseconds += elapsedNanoseconds(start);
+    }
+
+    // Using the results keeps the loops from being optimized away:
+    if (found != timings.operations || depths < 0)
+    {
+        cerr << "Some inserted keys were not found!" << endl;
+    }
+}
+
+// Function printResult
+// Input: stream, count, distinctKeys, height, peakKilobytes - Describe the
+//                                                            workload.
+//        operation - The name of the operation.
+//        operations - The number of operations timed.
+//        nanoseconds - The total time they took.
+// Output: Prints one CSV line.
+void printResult(KeyStream stream, size_t count, size_t distinctKeys,
+                 int height, long peakKilobytes, const char *operation,
+                 size_t operations, double nanoseconds)
+{
+    cout << STREAM_NAMES[stream] << "," << count << "," << distinctKeys << ","
+         << height << "," << operation << "," << operations << ","
+         << nanoseconds / operations << ","
+         << operations / (nanoseconds / 1e9) / 1e6 << ","
+         << peakKilobytes << endl;
+}
+
+// Function benchmarkWorkload
+// Input: stream - The kind of key stream.
+//        count - The number of keys in the stream.
+// Output: Prints the CSV lines of every operation on this workload.
+void benchmarkWorkload(KeyStream stream, size_t count)
+{
+    vector<int> keys = makeKeys(stream, count);
+    Timings timings;
+    int height = 0;
+    size_t distinctKeys = 0;
+
+    runWorkload(keys, timings, height, distinctKeys);
+
+    // Taken before printing, which allocates memory of its own:
+    struct rusage usage;
+    long peak;
+
+    getrusage(RUSAGE_SELF, &usage);
+    peak = usage.ru_maxrss;
+
+    // Destroying is one call per round, but it is reported per key like the
+    // other operations, so that sizes can be compared:
+    printResult(stream, count, distinctKeys, height, peak, "insertNode",
+                timings.operations, timings.insertNanoseconds);
+    printResult(stream, count, distinctKeys, height, peak, "containsNode",
+                timings.operations, timings.containsNanoseconds);
+    printResult(stream, count, distinctKeys, height, peak, "minimumDepth",
+                timings.operations, timings.minimumDepthNanoseconds);
+    printResult(stream, count, distinctKeys, height, peak, "removeNode",
+                timings.operations, timings.removeNanoseconds);
+    printResult(stream, count, distinctKeys, height, peak,
+                "destroyBinarySearchTree", timings.operations,
+                timings.destroyNanoseconds);
+}
+
+int main(int argc, char *argv[])
+{
+    // About 1000 nodes fill an L1 cache, 30000 an L2, 500000 a typical last
+    // level cache, and 4 million are many times larger than any:
+    vector<size_t> sizes;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        sizes.push_back(strtoul(argv[i], NULL, 10));
+    }
+
+    if (sizes.empty())
+    {
+        sizes.push_back(1000);
+        sizes.push_back(30000);
+        sizes.push_back(500000);
+        sizes.push_back(4000000);
+    }
+
+    cout << "stream,keys,distinct_keys,height,operation,operations,"
+         << "ns_per_op,mops_per_s,peak_rss_kb" << endl;
+
+    for (int stream = SORTED; stream <= ZIPF; ++stream)
+    {
+        for (size_t i = 0; i < sizes.size(); ++i)
+        {
+            if (sizes[i] == 0)
+            {
+                continue;
+            }
+
+            // Nothing may be left in the buffers for the child to repeat:
+            cout.flush();
+
+            pid_t child = fork();
+
+            if (child == 0)
+            {
+                benchmarkWorkload(static_cast<KeyStream>(stream), sizes[i]);
+                cout.flush();
+                _exit(0);
+            }
+            else if (child > 0)
+            {
+                waitpid(child, NULL, 0);
+            }
+            // Without a child the peak RSS includes earlier workloads:
+            else
+            {
+                benchmarkWorkload(static_cast<KeyStream>(stream), sizes[i]);
+            }
+        }
+    }
+
+    return 0;
+}
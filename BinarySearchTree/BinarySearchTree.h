@@ -1,50 +1,2505 @@
 /*  File BinaryTree.h
- *  This file contains the declaration of the Node structure and
- *  BinarySearchTree class.
+ *  This file contains the declaration and implementation of the
+ *  BinarySearchTreeNode structure and BasicBinarySearchTree class template.
  *  A binary search tree is a collection of nodes. Each node contains a key
  *  value and pointers to two child nodes called 'left' and 'right'. The tree
  *  has no duplicate keys, and every node's left child contains keys smaller
  *  than the node's key, and right child contains keys larger than the node's key.
+ *
+ *  The tree is self-balancing (an AVL tree): each node also stores the height
+ *  of its subtree, and after every insertion or removal the heights of the
+ *  left and right subtrees of any node differ by at most one. This keeps the
+ *  height of the tree, and therefore the cost of every operation, O(log n)
+ *  even when keys are inserted in sorted order. Each node also stores the
+ *  length of the shortest path down from it, so the minimum and maximum
+ *  depths of the tree can be read without a traversal.
+ *
+ *  Each node also stores the number of nodes in its subtree. That lets the
+ *  tree find the rank of a key, the key with a given rank, and the number of
+ *  keys in a range in O(log n) time without visiting the keys themselves.
+ *
+ *  Each node also points to its parent, so the keys can be walked in order,
+ *  in either direction, with STL-style iterators that are just a node
+ *  pointer. Moving an iterator allocates nothing and costs O(1) amortized,
+ *  so reading the k keys of a range costs O(log n + k). Inserting keys does
+ *  not invalidate iterators; removing a key only invalidates iterators to
+ *  that key.
+ *  visit() presents every key with its level in breadth-first, in-order,
+ *  pre-order or post-order, without allocating, and TreeDumper builds on it
+ *  to write the keys of a tree to a file as text or binary.
+ *
+ *  Nodes are obtained from a NodeAllocator owned by the tree, so inserting
+ *  and removing keys recycles node memory instead of calling new and delete,
+ *  and destroying the tree frees whole pages at a time.
+ *
+ *  The tree is a template on four types:
+ *  (a) Key, the type of the keys,
+ *  (b) Value, the type of a value stored with each key, or void (the
+ *      default) for a tree of keys only,
+ *  (c) Compare, a function object ordering the keys, less<Key> by default,
+ *  (d) Statistics, NoStatistics (the default) or TreeStatistics, chosen at
+ *      compile time. TreeStatistics records the length of every search path
+ *      and counts node allocations; NoStatistics compiles to nothing. See
+ *      TreeStatistics.h.
+ *  Keys and values are constructed in place inside their node by emplaceNode
+ *  and are never copied or moved afterwards, even by removals. When Compare
+ *  is transparent, e.g. less<>, lookups accept any type it can compare with
+ *  the keys, so a string_view can find a string key without a temporary.
+ *  BinarySearchTree is the int-keyed tree without values, and
+ *  InstrumentedBinarySearchTree the same tree with TreeStatistics.
+ *
+ *  Set operations between trees (unionWith, intersectWith, differenceWith)
+ *  are built from two primitives, split and join, in the style of Blelloch,
+ *  Ferizovic and Sun's "Just Join for Parallel Ordered Sets". Combining a
+ *  tree of n keys with one of m <= n keys costs O(m log(n/m + 1)) work, and
+ *  the two halves of each step are independent, so large operations run
+ *  them on separate threads.
+ *
+ *  Compile with -std=c++11 (or later), and with -pthread if the set
+ *  operations are used.
  */
 
 #ifndef BINARY_SEARCH_TREE_H
 #define BINARY_SEARCH_TREE_H
 
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "FrozenBinarySearchTree.h"
+#include "NodeAllocator.h"
+#include "RingBuffer.h"
+#include "TreeDumper.h"
+#include "TreeStatistics.h"
+
 using namespace std;
 
-// Data Structure: Node
-struct Node
+// Data Structure: BinarySearchTreeNode
+template <class Key, class Value>
+struct BinarySearchTreeNode
+{
+    template <class K, class... Args>
+    BinarySearchTreeNode(K &&newKey, Args &&... valueArgs)
+        : key(forward<K>(newKey)), value(forward<Args>(valueArgs)...)
+    {
+    }
+
+    Key key;
+    Value value;
+    // Numbers of nodes on the longest and shortest paths down to a missing
+    // child. Neither can exceed MAX_HEIGHT, so both fit in a short:
+    short height;
+    short minHeight;
+    size_t size; // Number of nodes in the subtree rooted here.
+    BinarySearchTreeNode *parent; // NULL for the root.
+    BinarySearchTreeNode *left;
+    BinarySearchTreeNode *right;
+};
+
+// Trees without values use nodes without a value member, so that they are no
+// larger than they need to be:
+template <class Key>
+struct BinarySearchTreeNode<Key, void>
 {
-    int key;
-    Node *left;
-    Node *right;
+    template <class K>
+    BinarySearchTreeNode(K &&newKey)
+        : key(forward<K>(newKey))
+    {
+    }
+
+    Key key;
+    // Numbers of nodes on the longest and shortest paths down to a missing
+    // child. Neither can exceed MAX_HEIGHT, so both fit in a short:
+    short height;
+    short minHeight;
+    size_t size; // Number of nodes in the subtree rooted here.
+    BinarySearchTreeNode *parent; // NULL for the root.
+    BinarySearchTreeNode *left;
+    BinarySearchTreeNode *right;
 };
 
 // Data Structure: Binary Tree
-class BinarySearchTree
+template <class Key, class Value = void, class Compare = less<Key>,
+          class Statistics = NoStatistics>
+class BasicBinarySearchTree
 {
     public:
-        BinarySearchTree();
-        ~BinarySearchTree();
+        typedef BinarySearchTreeNode<Key, Value> Node;
+
+        // Data Structure: const_iterator
+        // A bidirectional iterator over the keys in increasing order. Keys
+        // cannot be changed through it, since that could break the order.
+        class const_iterator
+        {
+            public:
+                typedef bidirectional_iterator_tag iterator_category;
+                typedef Key value_type;
+                typedef ptrdiff_t difference_type;
+                typedef const Key *pointer;
+                typedef const Key &reference;
+
+                const_iterator()
+                {
+                    m_node = NULL;
+                    m_tree = NULL;
+                }
+
+                const Key &operator*() const
+                {
+                    return m_node->key;
+                }
+
+                const Key *operator->() const
+                {
+                    return &m_node->key;
+                }
+
+                const_iterator &operator++()
+                {
+                    m_node = nextNode(m_node);
+                    return *this;
+                }
+
+                const_iterator operator++(int)
+                {
+                    const_iterator previous = *this;
 
-        void insertNode(int key);
-        void removeNode(int key); 
-        bool containsNode(int key);
+                    m_node = nextNode(m_node);
+                    return previous;
+                }
+
+                // Stepping back from end() gives the largest key:
+                const_iterator &operator--()
+                {
+                    m_node = (m_node != NULL ? previousNode(m_node) :
+                              maximumNode(m_tree->m_root));
+                    return *this;
+                }
+
+                const_iterator operator--(int)
+                {
+                    const_iterator previous = *this;
+
+                    --*this;
+                    return previous;
+                }
+
+                bool operator==(const const_iterator &other) const
+                {
+                    return m_node == other.m_node;
+                }
+
+                bool operator!=(const const_iterator &other) const
+                {
+                    return m_node != other.m_node;
+                }
+
+            private:
+                friend class BasicBinarySearchTree;
+
+                const_iterator(Node *node, const BasicBinarySearchTree *tree)
+                {
+                    m_node = node;
+                    m_tree = tree;
+                }
+
+                Node *m_node; // NULL for end().
+                const BasicBinarySearchTree *m_tree;
+        };
+
+        // Like std::set, the keys are never modifiable through an iterator:
+        typedef const_iterator iterator;
+
+        BasicBinarySearchTree(size_t nodesPerPage =
+                                  NodeAllocator<Node>::DEFAULT_NODES_PER_PAGE,
+                              const Compare &compare = Compare());
+        ~BasicBinarySearchTree();
+
+        void buildFromSortedKeys(const Key *keys, size_t count);
+        void buildFromKeys(const Key *keys, size_t count);
+        void insertNode(const Key &key);
+        void insertNode(Key &&key);
+        template <class K, class... Args>
+        bool emplaceNode(K &&key, Args &&... valueArgs);
+        void removeNode(const Key &key);
+        template <class K, class C = Compare,
+                  class = typename C::is_transparent>
+        void removeNode(const K &key);
+        bool containsNode(const Key &key);
+        template <class K, class C = Compare,
+                  class = typename C::is_transparent>
+        bool containsNode(const K &key);
+        void containsNodes(const Key *keys, size_t count, bool *found);
+        Value *findValue(const Key &key);
+        template <class K, class C = Compare,
+                  class = typename C::is_transparent>
+        Value *findValue(const K &key);
+        size_t size();
+        size_t rank(const Key &key);
+        const Key *select(size_t index);
+        size_t countInRange(const Key &low, const Key &high);
+        const_iterator begin();
+        const_iterator end();
+        const_iterator lower_bound(const Key &key);
+        template <class K, class C = Compare,
+                  class = typename C::is_transparent>
+        const_iterator lower_bound(const K &key);
+        const_iterator upper_bound(const Key &key);
+        template <class K, class C = Compare,
+                  class = typename C::is_transparent>
+        const_iterator upper_bound(const K &key);
+        bool successor(const Key &key, Key &next);
+        bool predecessor(const Key &key, Key &previous);
+        template <class Function>
+        void forEachInRange(const Key &low, const Key &high,
+                            Function callback);
         int minimumDepth();
+        int maximumDepth();
+        int measureMinimumDepth();
+        template <class Function>
+        void visit(TraversalOrder order, Function visitor);
+        template <class Function, class LevelFunction>
+        void visitBreadthFirst(Function visitor, LevelFunction endLevel);
         void printBinarySearchTree();
         void destroyBinarySearchTree();
+        void freeze(FrozenBinarySearchTree<Key, Compare> &snapshot);
+        bool save(const char *path);
+        void unionWith(BasicBinarySearchTree &other);
+        void intersectWith(BasicBinarySearchTree &other);
+        void differenceWith(BasicBinarySearchTree &other);
+        TreeStatisticsSnapshot statistics();
+        void resetStatistics();
 
     private:
-        Node *insertNode(int key, Node *node);
-        Node *removeNode(int key, Node *node);
-        Node *findSmallestNode(Node *node);
-        Node *findLargestNode(Node *node);
-        Node *findNode(int key, Node *node);
-        int minimumDepth(Node *node);
-        void printBinarySearchTree(Node *node);
-        void destroyBinarySearchTree(Node* node);
+        // An AVL tree of n nodes is less than 1.45 log2(n + 2) tall, so this
+        // bounds the height of any tree that fits in a 64-bit address space:
+        static const int MAX_HEIGHT = 96;
+
+        // The number of searches containsNodes advances together. Enough to
+        // keep many cache misses in flight, few enough that the state of
+        // every search stays in registers or L1.
+        static const size_t SEARCH_GROUP_SIZE = 16;
+
+        // The smallest number of keys, in both trees together, for which a
+        // step of a set operation hands one of its halves to another
+        // thread. Below this, starting a thread costs more than it saves.
+        static const size_t PARALLEL_CUTOFF = 1 << 14;
+
+        // Subtrees removed by a set operation and waiting to be freed,
+        // chained through the parent links of their roots:
+        struct NodeList
+        {
+            Node *head;
+            Node *tail;
+        };
+
+        // Copying would share, and later release twice, the same nodes:
+        BasicBinarySearchTree(const BasicBinarySearchTree &);
+        BasicBinarySearchTree &operator=(const BasicBinarySearchTree &);
+
+        template <class... Args>
+        Node *constructNode(Args &&... args);
+        Node *buildBalancedSubtree(const Key *keys, size_t count);
+        template <class K>
+        Node *findNode(const K &key, Node *node);
+        template <class K>
+        void removeKey(const K &key);
+        void destroyNodes(Node *node, bool freeMemory);
+        int height(Node *node);
+        int minHeight(Node *node);
+        size_t size(Node *node);
+        template <class K>
+        size_t countKeysBelow(const K &key, bool inclusive);
+        template <class K>
+        Node *findBound(const K &key, bool inclusive);
+        static Node *minimumNode(Node *node);
+        static Node *maximumNode(Node *node);
+        static Node *nextNode(Node *node);
+        static Node *previousNode(Node *node);
+        void updateNode(Node *node);
+        Node *rotateLeft(Node *node);
+        Node *rotateRight(Node *node);
+        Node *rebalance(Node *node);
+        void rebalancePath(Node ***path, int depth, int sizeChange);
+        Node *linkNode(Node *left, Node *middle, Node *right);
+        Node *join(Node *left, Node *middle, Node *right);
+        Node *joinRight(Node *left, Node *middle, Node *right);
+        Node *joinLeft(Node *left, Node *middle, Node *right);
+        Node *joinWithoutMiddle(Node *left, Node *right);
+        Node *splitLast(Node *node, Node *&last);
+        template <class K>
+        void split(Node *node, const K &key, Node *&left, Node *&found,
+                   Node *&right);
+        Node *unionNodes(Node *node, Node *otherNode, void **slots,
+                         char *used, size_t firstRank, int forkDepth);
+        Node *copyNodes(Node *otherNode, void **slots, char *used,
+                        size_t firstRank, int forkDepth);
+        Node *intersectNodes(Node *node, Node *otherNode,
+                             NodeList &discarded, int forkDepth);
+        Node *differenceNodes(Node *node, Node *otherNode,
+                              NodeList &discarded, int forkDepth);
+        static void discard(NodeList &list, Node *subtree);
+        static void appendList(NodeList &list, NodeList &other);
+        void releaseList(NodeList &list);
+        static int parallelDepth();
+        template <class LeftTask, class RightTask>
+        static void forkJoin(bool parallel, LeftTask leftTask,
+                             RightTask rightTask);
+        int measureMinimumDepth(Node *node);
+        template <class Function>
+        void visitDepthFirst(TraversalOrder order, Function visitor);
 
         Node *m_root;
+        NodeAllocator<Node> m_allocator;
+        Compare m_compare;
+        RingBuffer<Node *> m_levelQueue; // Kept for reuse by visitBreadthFirst.
+        Statistics m_statistics;
 };
 
+// Data Structure: BinarySearchTree
+// A tree of integer keys without values.
+typedef BasicBinarySearchTree<int> BinarySearchTree;
+
+// Data Structure: InstrumentedBinarySearchTree
+// A BinarySearchTree that also collects TreeStatistics.
+typedef BasicBinarySearchTree<int, void, less<int>, TreeStatistics>
+    InstrumentedBinarySearchTree;
+
+
+////
+//// Public Functions:
+////
+
+template <class Key, class Value, class Compare, class Statistics>
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::BasicBinarySearchTree(
+    size_t nodesPerPage, const Compare &compare)
+    : m_allocator(nodesPerPage), m_compare(compare)
+{
+    m_root = NULL;
+}
+
+template <class Key, class Value, class Compare, class Statistics>
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::~BasicBinarySearchTree()
+{
+    destroyBinarySearchTree();
+}
+
+// Public Function: buildFromSortedKeys
+// Input: keys - Keys in non-decreasing order.
+//        count - The number of keys.
+// Output: None.
+// Replaces the contents of the tree with the input keys in O(n) time. Repeated
+// keys are stored once, just as if each key had been passed to insertNode, and
+// values are default constructed.
+// The middle key becomes the root and each half is built the same way, which
+// gives a perfectly balanced tree whose nodes sit in one contiguous page in
+// the order a search visits them, top levels first.
+template <class Key, class Value, class Compare, class Statistics>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::buildFromSortedKeys(
+    const Key *keys, size_t count)
+{
+    size_t uniqueCount = 0;
+
+    destroyBinarySearchTree();
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i == 0 || m_compare(keys[i-1], keys[i]))
+        {
+            ++uniqueCount;
+        }
+    }
+
+    m_allocator.reserve(uniqueCount);
+
+    // Most inputs have no repeats and can be used as they are. Otherwise
+    // build from a copy with the repeats dropped:
+    if (uniqueCount == count)
+    {
+        m_root = buildBalancedSubtree(keys, count);
+    }
+    else
+    {
+        vector<Key> uniqueKeys;
+
+        uniqueKeys.reserve(uniqueCount);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (i == 0 || m_compare(keys[i-1], keys[i]))
+            {
+                uniqueKeys.push_back(keys[i]);
+            }
+        }
+
+        m_root = buildBalancedSubtree(&uniqueKeys[0], uniqueCount);
+    }
+}
+
+// Public Function: buildFromKeys
+// Input: keys - Keys in any order.
+//        count - The number of keys.
+// Output: None.
+// Sorts a copy of the keys and then builds the tree with buildFromSortedKeys,
+// so the total cost is that of the sort, O(n log n).
+template <class Key, class Value, class Compare, class Statistics>
+void BasicBinarySearchTree<Key, Value, Compare, Statistics>::buildFromKeys(
+    const Key *keys, size_t count)
+{
+    vector<Key> sortedKeys(keys, keys + count);
+
+    sort(sortedKeys.begin(), sortedKeys.end(), m_compare);
+    buildFromSortedKeys(sortedKeys.empty() ? NULL : &sortedKeys[0], count);
+}
+
+// Public Function: insertNode
+// Input: key - Key to be added to the tree.
+// Output: None.
+// If the tree stores values, the new key's value is default constructed.
+template <class Key, class Value, class Compare, class Statistics>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::insertNode(
+    const Key &key)
+{
+    emplaceNode(key);
+}
+
+// Public Function: insertNode
+// Input: key - Key to be moved into the tree.
+// Output: None.
+// The key is only moved from if it was not already in the tree.
+template <class Key, class Value, class Compare, class Statistics>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::insertNode(Key &&key)
+{
+    emplaceNode(move(key));
+}
+
+// Public Function: emplaceNode
+// Input: key - Key to be added to the tree, or the argument to construct it
+//              from.
+//        valueArgs - Arguments for the constructor of the value stored with
+//                    the key (none for a tree without values).
+// Output: Returns true if the key was added, or false if the tree already
+//          contained it, in which case nothing is constructed.
+// We descend with a pointer to the link that points at the current node, so
+// that when we fall off the tree the link where the new node belongs is
+// already in hand. The links visited are remembered in a fixed-size path so
+// the heights can be fixed on the way back up without recursion.
+template <class Key, class Value, class Compare, class Statistics>
+template <class K, class... Args>
+bool BasicBinarySearchTree<Key, Value, Compare, Statistics>::emplaceNode(
+    K &&key, Args &&... valueArgs)
+{
+    Node **path[MAX_HEIGHT];
+    int depth = 0;
+    Node **link = &m_root;
+    Node *parent = NULL;
+
+    while (*link != NULL)
+    {
+        Node *node = *link;
+
+        path[depth++] = link;
+        parent = node;
+
+        // Smaller values go to the left child:
+        if (m_compare(key, node->key))
+        {
+            link = &node->left;
+        }
+        // Larger values go to the right child:
+        else if (m_compare(node->key, key))
+        {
+            link = &node->right;
+        }
+        // Otherwise this node already contains the key:
+        else
+        {
+            m_statistics.recordInsertion(depth);
+            return false;
+        }
+    }
+
+    m_statistics.recordInsertion(depth);
+
+    // If we reach here then no node in the tree contains the key and link is
+    // the empty child where it belongs:
+    Node *node = constructNode(forward<K>(key), forward<Args>(valueArgs)...);
+    node->height = 1;
+    node->minHeight = 1;
+    node->size = 1;
+    node->parent = parent;
+    node->left = NULL;
+    node->right = NULL;
+    *link = node;
+
+    // The new node may have unbalanced its ancestors:
+    rebalancePath(path, depth, 1);
+
+    return true;
+}
+
+// Public Function: removeNode
+// Input: key - Key indicating which node to remove.
+// Output: None.
+template <class Key, class Value, class Compare, class Statistics>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::removeNode(
+    const Key &key)
+{
+    removeKey(key);
+}
+
+// Public Function: removeNode
+// Input: key - A value equivalent to the key of the node to remove.
+// Output: None.
+// Only available when Compare is transparent.
+template <class Key, class Value, class Compare, class Statistics>
+template <class K, class C, class>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::removeNode(const K &key)
+{
+    removeKey(key);
+}
+
+// Public Function: constainsNode
+// Input: key - The key to search for in the tree.
+// Output: Returns true if the tree contains a node whose key matches the input
+//          key, otherwise returns false.
+template <class Key, class Value, class Compare, class Statistics>
+bool
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::containsNode(
+    const Key &key)
+{
+    return findNode(key, m_root) != NULL;
+}
+
+// Public Function: constainsNode
+// Input: key - A value comparable with the keys of the tree.
+// Output: Returns true if the tree contains a node whose key is equivalent to
+//          the input, otherwise returns false.
+// Only available when Compare is transparent.
+template <class Key, class Value, class Compare, class Statistics>
+template <class K, class C, class>
+bool
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::containsNode(
+    const K &key)
+{
+    return findNode(key, m_root) != NULL;
+}
+
+// Public Function: containsNodes
+// Input: keys - The keys to search for in the tree.
+//        count - The number of keys.
+//        found - An array of count entries. found[i] is set to whether the
+//                tree contains keys[i].
+// Output: None.
+// Gives the same answers as calling containsNode on each key, but runs up to
+// SEARCH_GROUP_SIZE searches side by side, one level at a time. After each
+// step the next node of every search is prefetched, so the cache misses of
+// the whole group overlap instead of each search waiting on its own chain of
+// misses. Searches that finish drop out of the group; the group ends when
+// its last search does, which in a balanced tree is only a level or two
+// after the first.
+template <class Key, class Value, class Compare, class Statistics>
+void BasicBinarySearchTree<Key, Value, Compare, Statistics>::containsNodes(
+    const Key *keys, size_t count, bool *found)
+{
+    for (size_t start = 0; start < count; start += SEARCH_GROUP_SIZE)
+    {
+        size_t groupSize = count - start < SEARCH_GROUP_SIZE ?
+                           count - start : SEARCH_GROUP_SIZE;
+        Node *nodes[SEARCH_GROUP_SIZE];
+        size_t active[SEARCH_GROUP_SIZE]; // Searches still in progress.
+        size_t activeCount = groupSize;
+        int level = 0; // Every search in progress has compared this many.
+
+        for (size_t i = 0; i < groupSize; ++i)
+        {
+            nodes[i] = m_root;
+            active[i] = i;
+            found[start + i] = false;
+        }
+
+        while (activeCount > 0)
+        {
+            size_t stillActive = 0;
+
+            for (size_t a = 0; a < activeCount; ++a)
+            {
+                size_t i = active[a];
+                Node *node = nodes[i];
+
+                // Fell off the tree, so the key is not in it:
+                if (node == NULL)
+                {
+                    m_statistics.recordSearch(level);
+                    continue;
+                }
+
+                bool goLeft = m_compare(keys[start + i], node->key);
+                bool goRight = m_compare(node->key, keys[start + i]);
+
+                if (!goLeft && !goRight)
+                {
+                    m_statistics.recordSearch(level + 1);
+                    found[start + i] = true;
+                    continue;
+                }
+
+                node = (goRight ? node->right : node->left);
+                __builtin_prefetch(node);
+                nodes[i] = node;
+                active[stillActive++] = i;
+            }
+
+            activeCount = stillActive;
+            ++level;
+        }
+    }
+}
+
+// Public Function: findValue
+// Input: key - The key to search for in the tree.
+// Output: Returns a pointer to the value stored with the key, or NULL if the
+//          tree does not contain the key. The pointer stays valid until the
+//          key is removed or the tree is destroyed.
+template <class Key, class Value, class Compare, class Statistics>
+Value *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::findValue(
+    const Key &key)
+{
+    Node *node = findNode(key, m_root);
+
+    return node != NULL ? &node->value : NULL;
+}
+
+// Public Function: findValue
+// Input: key - A value comparable with the keys of the tree.
+// Output: Returns a pointer to the value stored with the equivalent key, or
+//          NULL if there is none.
+// Only available when Compare is transparent.
+template <class Key, class Value, class Compare, class Statistics>
+template <class K, class C, class>
+Value *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::findValue(const K &key)
+{
+    Node *node = findNode(key, m_root);
+
+    return node != NULL ? &node->value : NULL;
+}
+
+// Public Function: size
+// Input: None.
+// Output: The number of keys in the tree.
+template <class Key, class Value, class Compare, class Statistics>
+size_t BasicBinarySearchTree<Key, Value, Compare, Statistics>::size()
+{
+    return size(m_root);
+}
+
+// Public Function: rank
+// Input: key - Any key, whether or not it is in the tree.
+// Output: The number of keys in the tree that are smaller than key. For a key
+//          in the tree this is its position in sorted order, counting from 0.
+template <class Key, class Value, class Compare, class Statistics>
+size_t
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::rank(const Key &key)
+{
+    return countKeysBelow(key, false);
+}
+
+// Public Function: select
+// Input: index - A position in sorted order, counting from 0.
+// Output: Returns a pointer to the key at that position (the index+1-th
+//          smallest key), or NULL if the tree has no more than index keys.
+// At each node the size of the left subtree tells whether the wanted key is
+// on the left, is this node, or is on the right, where the index is reduced
+// by the keys skipped over.
+template <class Key, class Value, class Compare, class Statistics>
+const Key *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::select(size_t index)
+{
+    Node *node = m_root;
+
+    while (node != NULL)
+    {
+        size_t leftSize = size(node->left);
+
+        if (index < leftSize)
+        {
+            node = node->left;
+        }
+        else if (index > leftSize)
+        {
+            index -= leftSize + 1;
+            node = node->right;
+        }
+        else
+        {
+            return &node->key;
+        }
+    }
+
+    return NULL;
+}
+
+// Public Function: countInRange
+// Input: low - The smallest key to count.
+//        high - The largest key to count.
+// Output: The number of keys k in the tree with low <= k <= high, or zero if
+//          high is less than low.
+template <class Key, class Value, class Compare, class Statistics>
+size_t BasicBinarySearchTree<Key, Value, Compare, Statistics>::countInRange(
+    const Key &low, const Key &high)
+{
+    if (m_compare(high, low))
+    {
+        return 0;
+    }
+
+    return countKeysBelow(high, true) - countKeysBelow(low, false);
+}
+
+// Public Function: begin
+// Input: None.
+// Output: Returns an iterator to the smallest key, or end() if the tree is
+//          empty.
+template <class Key, class Value, class Compare, class Statistics>
+typename BasicBinarySearchTree<Key, Value, Compare, Statistics>::const_iterator
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::begin()
+{
+    return const_iterator(minimumNode(m_root), this);
+}
+
+// Public Function: end
+// Input: None.
+// Output: Returns the iterator one past the largest key.
+template <class Key, class Value, class Compare, class Statistics>
+typename BasicBinarySearchTree<Key, Value, Compare, Statistics>::const_iterator
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::end()
+{
+    return const_iterator(NULL, this);
+}
+
+// Public Function: lower_bound
+// Input: key - Any key, whether or not it is in the tree.
+// Output: Returns an iterator to the smallest key that is not less than key,
+//          or end() if there is none.
+template <class Key, class Value, class Compare, class Statistics>
+typename BasicBinarySearchTree<Key, Value, Compare, Statistics>::const_iterator
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::lower_bound(
+    const Key &key)
+{
+    return const_iterator(findBound(key, true), this);
+}
+
+// Public Function: lower_bound
+// Input: key - A value comparable with the keys of the tree.
+// Output: Returns an iterator to the smallest key that is not less than key,
+//          or end() if there is none.
+// Only available when Compare is transparent.
+template <class Key, class Value, class Compare, class Statistics>
+template <class K, class C, class>
+typename BasicBinarySearchTree<Key, Value, Compare, Statistics>::const_iterator
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::lower_bound(
+    const K &key)
+{
+    return const_iterator(findBound(key, true), this);
+}
+
+// Public Function: upper_bound
+// Input: key - Any key, whether or not it is in the tree.
+// Output: Returns an iterator to the smallest key that is greater than key,
+//          or end() if there is none.
+template <class Key, class Value, class Compare, class Statistics>
+typename BasicBinarySearchTree<Key, Value, Compare, Statistics>::const_iterator
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::upper_bound(
+    const Key &key)
+{
+    return const_iterator(findBound(key, false), this);
+}
+
+// Public Function: upper_bound
+// Input: key - A value comparable with the keys of the tree.
+// Output: Returns an iterator to the smallest key that is greater than key,
+//          or end() if there is none.
+// Only available when Compare is transparent.
+template <class Key, class Value, class Compare, class Statistics>
+template <class K, class C, class>
+typename BasicBinarySearchTree<Key, Value, Compare, Statistics>::const_iterator
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::upper_bound(
+    const K &key)
+{
+    return const_iterator(findBound(key, false), this);
+}
+
+// Public Function: successor
+// Input: key - Any key, in the tree or not.
+//        next - Set to the smallest key in the tree that is greater than key,
+//               if there is one.
+// Output: Returns true if there is such a key, otherwise returns false and
+//          leaves next unchanged.
+template <class Key, class Value, class Compare, class Statistics>
+bool BasicBinarySearchTree<Key, Value, Compare, Statistics>::successor(
+    const Key &key, Key &next)
+{
+    Node *node = findBound(key, false);
+
+    if (node == NULL)
+    {
+        return false;
+    }
+
+    next = node->key;
+    return true;
+}
+
+// Public Function: predecessor
+// Input: key - Any key, in the tree or not.
+//        previous - Set to the largest key in the tree that is less than key,
+//                   if there is one.
+// Output: Returns true if there is such a key, otherwise returns false and
+//          leaves previous unchanged.
+// The mirror image of findBound: every node smaller than key is remembered
+// before we look to its right for a larger one that is still smaller.
+template <class Key, class Value, class Compare, class Statistics>
+bool BasicBinarySearchTree<Key, Value, Compare, Statistics>::predecessor(
+    const Key &key, Key &previous)
+{
+    Node *node = m_root;
+    Node *bound = NULL;
+
+    while (node != NULL)
+    {
+        if (m_compare(node->key, key))
+        {
+            bound = node;
+            node = node->right;
+        }
+        else
+        {
+            node = node->left;
+        }
+    }
+
+    if (bound == NULL)
+    {
+        return false;
+    }
+
+    previous = bound->key;
+    return true;
+}
+
+// Public Function: forEachInRange
+// Input: low - The smallest key to visit.
+//        high - The largest key to visit.
+//        callback - Called as callback(key) for each key k in the tree with
+//                   low <= k <= high, in increasing order.
+// Output: None.
+// One descent finds the first key in the range and the rest are reached by
+// following the in-order successor links, so visiting k keys costs
+// O(log n + k) and nothing is allocated. The callback must not insert or
+// remove keys.
+template <class Key, class Value, class Compare, class Statistics>
+template <class Function>
+void BasicBinarySearchTree<Key, Value, Compare, Statistics>::forEachInRange(
+    const Key &low, const Key &high, Function callback)
+{
+    Node *node = findBound(low, true);
+
+    while (node != NULL && !m_compare(high, node->key))
+    {
+        callback(static_cast<const Key &>(node->key));
+        node = nextNode(node);
+    }
+}
+
+// Public Function: minimumDepth
+// Input: None.
+// Output: The number of nodes encountered on the shortest path to a leaf node.
+// Every node keeps the length of the shortest path below it up to date, so
+// this is a single read.
+template <class Key, class Value, class Compare, class Statistics>
+int BasicBinarySearchTree<Key, Value, Compare, Statistics>::minimumDepth()
+{
+    return minHeight(m_root);
+}
+
+// Public Function: maximumDepth
+// Input: None.
+// Output: The number of nodes encountered on the longest path to a leaf node,
+//          which is the height of the tree.
+template <class Key, class Value, class Compare, class Statistics>
+int BasicBinarySearchTree<Key, Value, Compare, Statistics>::maximumDepth()
+{
+    return height(m_root);
+}
+
+// Public Function: measureMinimumDepth
+// Input: None.
+// Output: The same as minimumDepth(), but found by searching the tree rather
+//          than read from the nodes.
+// Useful for checking the stored depths. It allocates nothing, but has to
+// visit every node shallower than the closest leaf.
+template <class Key, class Value, class Compare, class Statistics>
+int
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::measureMinimumDepth()
+{
+    return measureMinimumDepth(m_root);
+}
+
+// Public Function: visit
+// Input: order - The order in which to visit the nodes.
+//        visitor - Called as visitor(key, level) for every node, where level
+//                  is 0 for the root, 1 for its children, and so on.
+// Output: None.
+// Nothing is allocated, except that a breadth-first visit may grow the
+// tree's reusable queue. The visitor must not change the tree.
+template <class Key, class Value, class Compare, class Statistics>
+template <class Function>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::visit(
+    TraversalOrder order, Function visitor)
+{
+    if (order == BREADTH_FIRST)
+    {
+        visitBreadthFirst(visitor, [](int, size_t) {});
+    }
+    else
+    {
+        visitDepthFirst(order, visitor);
+    }
+}
+
+// Public Function: visitBreadthFirst
+// Input: visitor - Called as visitor(key, level) for every node, level by
+//                  level from the root and left to right within a level.
+//        endLevel - Called as endLevel(level, count) after the last node of
+//                   each level, with the number of nodes on that level.
+// Output: None.
+// The queue holds at most two levels at a time. It is kept by the tree and
+// only ever grows, so once it has been through the widest level of the tree
+// visiting allocates nothing. The visitor must not change the tree.
+template <class Key, class Value, class Compare, class Statistics>
+template <class Function, class LevelFunction>
+void BasicBinarySearchTree<Key, Value, Compare, Statistics>::visitBreadthFirst(
+    Function visitor, LevelFunction endLevel)
+{
+    int level = 0;
+
+    m_levelQueue.clear();
+
+    if (m_root != NULL)
+    {
+        m_levelQueue.pushBack(m_root);
+    }
+
+    while (!m_levelQueue.empty())
+    {
+        // The queue holds exactly the nodes of the current level here:
+        size_t levelSize = m_levelQueue.size();
+
+        for (size_t i = 0; i < levelSize; ++i)
+        {
+            Node *node = m_levelQueue.popFront();
+
+            visitor(static_cast<const Key &>(node->key), level);
+
+            if (node->left != NULL)
+            {
+                m_levelQueue.pushBack(node->left);
+            }
+
+            if (node->right != NULL)
+            {
+                m_levelQueue.pushBack(node->right);
+            }
+        }
+
+        endLevel(level, levelSize);
+        ++level;
+    }
+}
+
+// Public Function: printBinarySearchTree
+// Input: None.
+// Output: Non-graphical printing of the nodes of the tree in a breadth-first
+//          order.
+// The keys are formatted into one buffer and written to stdout in large
+// blocks, rather than through cout one key at a time.
+template <class Key, class Value, class Compare, class Statistics>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::printBinarySearchTree()
+{
+    cout << "Breadth-first traversal of binary search tree:" << endl;
+
+    TreeDumper dumper(stdout);
+
+    dumper.dumpText(*this, BREADTH_FIRST, ' ');
+
+    // cout may have its own buffer, so the keys must reach the terminal
+    // before anything else is written through it:
+    fflush(stdout);
+    cout << endl;
+}
+
+// Public Function: destroyBinarySearchTree
+// Input: none
+// Output: none
+// This function destroys the entire binary tree. Every node lives in one of
+// the allocator's pages, so the pages are released directly instead of
+// visiting each node. Only keys or values with destructors that must run
+// (such as strings) need a walk over the nodes first.
+template <class Key, class Value, class Compare, class Statistics>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::destroyBinarySearchTree()
+{
+    m_statistics.recordFrees(size(m_root));
+
+    if (!is_trivially_destructible<Node>::value)
+    {
+        destroyNodes(m_root, false);
+    }
+
+    m_allocator.releaseAll();
+    m_root = NULL;
+}
+
+// Public Function: freeze
+// Input: snapshot - The snapshot to fill with the current keys of the tree.
+// Output: None.
+// The snapshot is independent of the tree afterwards; later insertions and
+// removals are not reflected in it until freeze is called again. Passing the
+// same snapshot each time reuses its memory.
+// The nodes are visited in order by following the successor links, and each
+// key is copied straight into its place in the snapshot, so nothing but the
+// snapshot itself is allocated.
+template <class Key, class Value, class Compare, class Statistics>
+void BasicBinarySearchTree<Key, Value, Compare, Statistics>::freeze(
+    FrozenBinarySearchTree<Key, Compare> &snapshot)
+{
+    Node *node = minimumNode(m_root);
+
+    snapshot.rebuild(size(),
+                     [&]() -> const Key &
+                     {
+                         const Key &key = node->key;
+
+                         node = nextNode(node);
+
+                         return key;
+                     });
+}
+
+
+// Public Function: save
+// Input: path - The file to write the keys to.
+// Output: Returns true if the whole file was written.
+// Writes the keys in the snapshot format of FrozenBinarySearchTree, so the
+// file can be mapped and searched in place with
+// FrozenBinarySearchTree::loadMapped() instead of being read back into a
+// tree. Only keys that can be copied byte by byte can be saved.
+template <class Key, class Value, class Compare, class Statistics>
+bool
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::save(const char *path)
+{
+    FrozenBinarySearchTree<Key, Compare> snapshot(m_compare);
+
+    freeze(snapshot);
+
+    return snapshot.save(path);
+}
+
+// Public Function: unionWith
+// Input: other - Another tree with the same ordering. It is not changed.
+// Output: None.
+// Adds every key of other that is not already in this tree. Keys already
+// here keep their values; new keys get copies of other's values.
+// This tree is split by the root of other, each half is combined with the
+// matching subtree of other, and the results are joined around the root's
+// key. Only this tree's nodes are relinked; nodes for keys copied from other
+// are allocated up front, one per key of other, and indexed by the key's
+// rank in other, so the threads never share the allocator.
+template <class Key, class Value, class Compare, class Statistics>
+void BasicBinarySearchTree<Key, Value, Compare, Statistics>::unionWith(
+    BasicBinarySearchTree &other)
+{
+    size_t otherSize = other.size();
+
+    if (&other == this || otherSize == 0)
+    {
+        return;
+    }
+
+    vector<void *> slots(otherSize);
+    vector<char> used(otherSize, 0);
+
+    m_statistics.recordAllocations(otherSize);
+
+    for (size_t i = 0; i < otherSize; ++i)
+    {
+        slots[i] = m_allocator.allocate();
+    }
+
+    m_root = unionNodes(m_root, other.m_root, &slots[0], &used[0], 0,
+                        parallelDepth());
+    m_root->parent = NULL;
+
+    // Keys that were already here did not need their slots:
+    for (size_t i = 0; i < otherSize; ++i)
+    {
+        if (!used[i])
+        {
+            m_allocator.deallocate(slots[i]);
+            m_statistics.recordFrees(1);
+        }
+    }
+}
+
+// Public Function: intersectWith
+// Input: other - Another tree with the same ordering. It is not changed.
+// Output: None.
+// Removes every key that is not also in other. Freeing the removed nodes
+// adds O(1) per removed key to the cost of the operation itself.
+template <class Key, class Value, class Compare, class Statistics>
+void BasicBinarySearchTree<Key, Value, Compare, Statistics>::intersectWith(
+    BasicBinarySearchTree &other)
+{
+    NodeList discarded = { NULL, NULL };
+
+    if (&other == this)
+    {
+        return;
+    }
+
+    m_root = intersectNodes(m_root, other.m_root, discarded, parallelDepth());
+
+    if (m_root != NULL)
+    {
+        m_root->parent = NULL;
+    }
+
+    releaseList(discarded);
+}
+
+// Public Function: differenceWith
+// Input: other - Another tree with the same ordering. It is not changed.
+// Output: None.
+// Removes every key that is also in other.
+template <class Key, class Value, class Compare, class Statistics>
+void BasicBinarySearchTree<Key, Value, Compare, Statistics>::differenceWith(
+    BasicBinarySearchTree &other)
+{
+    NodeList discarded = { NULL, NULL };
+
+    if (&other == this)
+    {
+        destroyBinarySearchTree();
+        return;
+    }
+
+    m_root = differenceNodes(m_root, other.m_root, discarded,
+                             parallelDepth());
+
+    if (m_root != NULL)
+    {
+        m_root->parent = NULL;
+    }
+
+    releaseList(discarded);
+}
+
+// Public Function: statistics
+// Input: None.
+// Output: A copy of the counts collected since the tree was created or
+//          resetStatistics was last called. With NoStatistics every count
+//          is zero.
+// The lengths are recorded by containsNode, containsNodes, findValue,
+// insertNode, emplaceNode and removeNode. Nodes are counted as allocated
+// and freed by those and by every other function that creates or frees
+// them, including the set operations and destroyBinarySearchTree.
+template <class Key, class Value, class Compare, class Statistics>
+TreeStatisticsSnapshot
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::statistics()
+{
+    return m_statistics.snapshot();
+}
+
+// Public Function: resetStatistics
+// Input: None.
+// Output: None.
+template <class Key, class Value, class Compare, class Statistics>
+void BasicBinarySearchTree<Key, Value, Compare, Statistics>::resetStatistics()
+{
+    m_statistics.reset();
+}
+
+////
+//// Private functions:
+////
+
+// Private Function: constructNode
+// Input: args - The arguments for the constructor of the node: its key, and
+//               those for its value.
+// Output: Returns the new node, whose links and heights are left unset.
+// If the constructor of the key or value throws, the memory is handed back
+// to the allocator before the exception is passed on, and the node is not
+// counted as allocated.
+template <class Key, class Value, class Compare, class Statistics>
+template <class... Args>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::constructNode(
+    Args &&... args)
+{
+    void *memory = m_allocator.allocate();
+    Node *node = NULL;
+
+    try
+    {
+        node = new (memory) Node(forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        m_allocator.deallocate(memory);
+        throw;
+    }
+
+    m_statistics.recordAllocations(1);
+
+    return node;
+}
+
+// Private Function: buildBalancedSubtree
+// Input: keys - Distinct keys in increasing order.
+//        count - The number of keys.
+// Output: Returns the root of a perfectly balanced subtree holding the keys.
+// Each node is allocated before its children, so with memory reserved up
+// front the nodes are laid out in pre-order.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::buildBalancedSubtree(
+    const Key *keys, size_t count)
+{
+    if (count == 0)
+    {
+        return NULL;
+    }
+
+    size_t middle = count / 2;
+
+    Node *node = constructNode(keys[middle]);
+
+    node->parent = NULL;
+    node->left = buildBalancedSubtree(keys, middle);
+    node->right = buildBalancedSubtree(keys + middle + 1, count - middle - 1);
+    updateNode(node);
+
+    if (node->left != NULL)
+    {
+        node->left->parent = node;
+    }
+
+    if (node->right != NULL)
+    {
+        node->right->parent = node;
+    }
+
+    return node;
+}
+
+// Private Function: findNode
+// Input: key - The key indicating the node to search for.
+//        node - the root of the subtree we are searching.
+// Output: If the tree contains a node whose key matches the input key then
+//          this will return a pointer to that node. Otherwise it returns NULL.
+// Testing for equality first lets the compiler pick the next child with a
+// conditional move instead of an unpredictable branch.
+template <class Key, class Value, class Compare, class Statistics>
+template <class K>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::findNode(
+    const K &key, Node *node)
+{
+    int length = 0;
+
+    while (node != NULL)
+    {
+        bool goLeft = m_compare(key, node->key);
+        bool goRight = m_compare(node->key, key);
+
+        ++length;
+
+        if (!goLeft && !goRight)
+        {
+            m_statistics.recordSearch(length);
+            return node;
+        }
+
+        node = (goRight ? node->right : node->left);
+    }
+
+    m_statistics.recordSearch(length);
+
+    return NULL;
+}
+
+// Private Function: removeKey
+// Input: key - The key, or a value equivalent to it, of the node to remove.
+// Output: None.
+// If the node has a right subtree its successor, the smallest node on the
+// right, is unlinked from there and put in the node's place, so that keys and
+// values never move between nodes. Otherwise its left child (if any) takes
+// its place.
+template <class Key, class Value, class Compare, class Statistics>
+template <class K>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::removeKey(const K &key)
+{
+    Node **path[MAX_HEIGHT];
+    int depth = 0;
+    Node **link = &m_root;
+
+    // Find the link to the node containing the key:
+    while (*link != NULL)
+    {
+        if (m_compare(key, (*link)->key))
+        {
+            path[depth++] = link;
+            link = &(*link)->left;
+        }
+        else if (m_compare((*link)->key, key))
+        {
+            path[depth++] = link;
+            link = &(*link)->right;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    Node *node = *link;
+
+    if (node == NULL)
+    {
+        m_statistics.recordRemoval(depth);
+        return;
+    }
+
+    m_statistics.recordRemoval(depth + 1);
+
+    // With no right subtree, the left child replaces the node:
+    if (node->right == NULL)
+    {
+        *link = node->left;
+
+        if (node->left != NULL)
+        {
+            node->left->parent = node->parent;
+        }
+    }
+    // Otherwise unlink the successor and move it into the node's place:
+    else
+    {
+        int nodeDepth = depth;
+        Node **successorLink = &node->right;
+
+        m_statistics.recordSuccessorReplacement();
+
+        path[depth++] = link;
+
+        while ((*successorLink)->left != NULL)
+        {
+            path[depth++] = successorLink;
+            successorLink = &(*successorLink)->left;
+        }
+
+        Node *successor = *successorLink;
+
+        *successorLink = successor->right;
+
+        if (successor->right != NULL)
+        {
+            successor->right->parent = successor->parent;
+        }
+
+        successor->left = node->left;
+        successor->right = node->right;
+        successor->parent = node->parent;
+        successor->height = node->height;
+        successor->minHeight = node->minHeight;
+        successor->size = node->size;
+        *link = successor;
+
+        if (successor->left != NULL)
+        {
+            successor->left->parent = successor;
+        }
+
+        if (successor->right != NULL)
+        {
+            successor->right->parent = successor;
+        }
+
+        // The path went through the removed node's right link, which is now
+        // the successor's:
+        if (depth > nodeDepth + 1)
+        {
+            path[nodeDepth + 1] = &successor->right;
+        }
+    }
+
+    node->~Node();
+    m_allocator.deallocate(node);
+    m_statistics.recordFrees(1);
+
+    // The removal may have unbalanced the ancestors of the unlinked node:
+    rebalancePath(path, depth, -1);
+}
+
+// Private Function: destroyNodes
+// Input: node - The root of the subtree whose nodes are destroyed.
+//        freeMemory - Whether each node's memory is also handed back to the
+//                     allocator, rather than left for releaseAll().
+// Output: None.
+// Runs the destructor of every node. Rotating each left child up until there
+// is none flattens the tree into a list as we go, so no stack is needed
+// however tall the tree is.
+template <class Key, class Value, class Compare, class Statistics>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::destroyNodes(
+    Node *node, bool freeMemory)
+{
+    while (node != NULL)
+    {
+        if (node->left != NULL)
+        {
+            Node *left = node->left;
+
+            node->left = left->right;
+            left->right = node;
+            node = left;
+        }
+        else
+        {
+            Node *right = node->right;
+
+            node->~Node();
+
+            if (freeMemory)
+            {
+                m_allocator.deallocate(node);
+                m_statistics.recordFrees(1);
+            }
+
+            node = right;
+        }
+    }
+}
+
+// Private Function: height
+// Input: node - The root of the subtree whose height we want.
+// Output: The number of nodes on the longest path from node down to a leaf,
+//          or zero for an empty subtree.
+template <class Key, class Value, class Compare, class Statistics>
+int BasicBinarySearchTree<Key, Value, Compare, Statistics>::height(Node *node)
+{
+    if (node != NULL)
+    {
+        return node->height;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+// Private Function: minHeight
+// Input: node - The root of the subtree whose shortest path we want.
+// Output: The number of nodes on the shortest path from node down to a
+//          missing child, or zero for an empty subtree.
+template <class Key, class Value, class Compare, class Statistics>
+int
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::minHeight(Node *node)
+{
+    if (node != NULL)
+    {
+        return node->minHeight;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+// Private Function: size
+// Input: node - The root of a subtree.
+// Output: The number of nodes in the subtree, or zero if it is empty.
+template <class Key, class Value, class Compare, class Statistics>
+size_t BasicBinarySearchTree<Key, Value, Compare, Statistics>::size(Node *node)
+{
+    if (node != NULL)
+    {
+        return node->size;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+// Private Function: updateNode
+// Input: node - A node whose children's heights, shortest paths and sizes
+//                are already correct.
+// Output: None.
+// Recomputes the node's height, shortest path and size from those of its
+// children.
+template <class Key, class Value, class Compare, class Statistics>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::updateNode(Node *node)
+{
+    int leftHeight = height(node->left);
+    int rightHeight = height(node->right);
+    int leftMinHeight = minHeight(node->left);
+    int rightMinHeight = minHeight(node->right);
+
+    node->height = 1 + (leftHeight > rightHeight ? leftHeight : rightHeight);
+    node->minHeight = 1 + (leftMinHeight < rightMinHeight ? leftMinHeight :
+                           rightMinHeight);
+    node->size = 1 + size(node->left) + size(node->right);
+}
+
+// Private Function: countKeysBelow
+// Input: key - The key to compare against.
+//        inclusive - Whether keys equal to key are counted too.
+// Output: The number of keys in the tree less than key (or less than or equal
+//          to it, if inclusive is true).
+// Whenever the search goes right, the node and its whole left subtree are
+// smaller than the key and are counted without being visited.
+template <class Key, class Value, class Compare, class Statistics>
+template <class K>
+size_t BasicBinarySearchTree<Key, Value, Compare, Statistics>::countKeysBelow(
+    const K &key, bool inclusive)
+{
+    Node *node = m_root;
+    size_t count = 0;
+
+    while (node != NULL)
+    {
+        if (m_compare(node->key, key))
+        {
+            count += size(node->left) + 1;
+            node = node->right;
+        }
+        else if (m_compare(key, node->key))
+        {
+            node = node->left;
+        }
+        else
+        {
+            return count + size(node->left) + (inclusive ? 1 : 0);
+        }
+    }
+
+    return count;
+}
+
+// Private Function: findBound
+// Input: key - The key to compare against.
+//        inclusive - Whether a key equal to key is acceptable.
+// Output: Returns the node with the smallest key that is greater than key (or
+//          not less than it, if inclusive is true), or NULL if there is none.
+// Every node that qualifies is remembered before we look to its left for a
+// smaller one that also qualifies.
+template <class Key, class Value, class Compare, class Statistics>
+template <class K>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::findBound(
+    const K &key, bool inclusive)
+{
+    Node *node = m_root;
+    Node *bound = NULL;
+
+    while (node != NULL)
+    {
+        bool qualifies = (inclusive ? !m_compare(node->key, key) :
+                          m_compare(key, node->key));
+
+        if (qualifies)
+        {
+            bound = node;
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+
+    return bound;
+}
+
+// Private Function: minimumNode
+// Input: node - The root of a subtree, or NULL.
+// Output: Returns the node with the smallest key in the subtree, or NULL if
+//          it is empty.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::minimumNode(Node *node)
+{
+    if (node != NULL)
+    {
+        while (node->left != NULL)
+        {
+            node = node->left;
+        }
+    }
+
+    return node;
+}
+
+// Private Function: maximumNode
+// Input: node - The root of a subtree, or NULL.
+// Output: Returns the node with the largest key in the subtree, or NULL if
+//          it is empty.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::maximumNode(Node *node)
+{
+    if (node != NULL)
+    {
+        while (node->right != NULL)
+        {
+            node = node->right;
+        }
+    }
+
+    return node;
+}
+
+// Private Function: nextNode
+// Input: node - A node of the tree.
+// Output: Returns the node with the next larger key, or NULL if node has the
+//          largest key.
+// If the node has a right subtree the successor is the smallest node there.
+// Otherwise it is the first ancestor whose left subtree we are climbing out
+// of. Over a walk through the whole tree every link is followed once down
+// and once up, so each step costs O(1) amortized.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::nextNode(Node *node)
+{
+    if (node->right != NULL)
+    {
+        return minimumNode(node->right);
+    }
+
+    while (node->parent != NULL && node->parent->right == node)
+    {
+        node = node->parent;
+    }
+
+    return node->parent;
+}
+
+// Private Function: previousNode
+// Input: node - A node of the tree.
+// Output: Returns the node with the next smaller key, or NULL if node has
+//          the smallest key.
+// This is the mirror image of nextNode.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::previousNode(Node *node)
+{
+    if (node->left != NULL)
+    {
+        return maximumNode(node->left);
+    }
+
+    while (node->parent != NULL && node->parent->left == node)
+    {
+        node = node->parent;
+    }
+
+    return node->parent;
+}
+
+// Private Function: rotateLeft
+// Input: node - The root of the subtree to rotate. It must have a right child.
+// Output: Returns the new root of the subtree, which is the old right child.
+//          The caller must store it in the link that pointed to node; its
+//          parent is already node's old parent.
+//
+//        (node)                 (pivot)
+//        *     *               *       *
+//      (A)   (pivot)   =>   (node)     (C)
+//             *    *        *    *
+//           (B)    (C)    (A)    (B)
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::rotateLeft(Node *node)
+{
+    Node *pivot = node->right;
+
+    node->right = pivot->left;
+    pivot->left = node;
+    pivot->parent = node->parent;
+    node->parent = pivot;
+
+    if (node->right != NULL)
+    {
+        node->right->parent = node;
+    }
+
+    updateNode(node);
+    updateNode(pivot);
+
+    return pivot;
+}
+
+// Private Function: rotateRight
+// Input: node - The root of the subtree to rotate. It must have a left child.
+// Output: Returns the new root of the subtree, which is the old left child.
+// This is the mirror image of rotateLeft.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::rotateRight(Node *node)
+{
+    Node *pivot = node->left;
+
+    node->left = pivot->right;
+    pivot->right = node;
+    pivot->parent = node->parent;
+    node->parent = pivot;
+
+    if (node->left != NULL)
+    {
+        node->left->parent = node;
+    }
+
+    updateNode(node);
+    updateNode(pivot);
+
+    return pivot;
+}
+
+// Private Function: rebalance
+// Input: node - The root of a subtree whose children are balanced, but whose
+//                own children's heights may differ by up to two.
+// Output: Returns the new root of the subtree after restoring the AVL
+//          property with at most two rotations.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::rebalance(Node *node)
+{
+    updateNode(node);
+
+    int balance = height(node->left) - height(node->right);
+
+    // Left subtree is too tall:
+    if (balance > 1)
+    {
+        // Left-right case, reduce it to the left-left case first:
+        if (height(node->left->left) < height(node->left->right))
+        {
+            node->left = rotateLeft(node->left);
+        }
+
+        return rotateRight(node);
+    }
+    // Right subtree is too tall:
+    else if (balance < -1)
+    {
+        // Right-left case, reduce it to the right-right case first:
+        if (height(node->right->right) < height(node->right->left))
+        {
+            node->right = rotateRight(node->right);
+        }
+
+        return rotateLeft(node);
+    }
+
+    return node;
+}
+
+// Private Function: rebalancePath
+// Input: path - The links followed from the root down to a changed subtree;
+//                path[0] is &m_root.
+//        depth - The number of links in path.
+//        sizeChange - +1 after an insertion, -1 after a removal.
+// Output: None.
+// Rebalances the subtree behind each link, from the deepest up. Once a
+// subtree ends up with the same height and shortest path as before, nothing
+// above it can need rebalancing or new depths, so the remaining ancestors
+// only have their sizes adjusted.
+// Adjusting rather than recomputing the sizes avoids touching the children
+// that are off the path, which are probably not in the cache.
+template <class Key, class Value, class Compare, class Statistics>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::rebalancePath(
+    Node ***path, int depth, int sizeChange)
+{
+    int i = depth - 1;
+
+    for (; i >= 0; --i)
+    {
+        Node *node = *path[i];
+        int oldHeight = node->height;
+        int oldMinHeight = node->minHeight;
+
+        *path[i] = rebalance(node);
+
+        if ((*path[i])->height == oldHeight &&
+            (*path[i])->minHeight == oldMinHeight)
+        {
+            --i;
+            break;
+        }
+    }
+
+    for (; i >= 0; --i)
+    {
+        (*path[i])->size += sizeChange;
+    }
+}
+
+// Private Function: linkNode
+// Input: left - A balanced subtree whose keys are all smaller than middle's.
+//        middle - A node whose own links are ignored.
+//        right - A balanced subtree whose keys are all larger than middle's.
+//                The heights of left and right differ by at most one.
+// Output: Returns middle, as the root of a subtree with the given children.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::linkNode(
+    Node *left, Node *middle, Node *right)
+{
+    middle->left = left;
+    middle->right = right;
+
+    if (left != NULL)
+    {
+        left->parent = middle;
+    }
+
+    if (right != NULL)
+    {
+        right->parent = middle;
+    }
+
+    updateNode(middle);
+
+    return middle;
+}
+
+// Private Function: join
+// Input: left - A balanced subtree whose keys are all smaller than middle's.
+//        middle - A node whose own links are ignored.
+//        right - A balanced subtree whose keys are all larger than middle's.
+// Output: Returns the root of a balanced subtree holding all the nodes.
+// The parent link of the returned root is not meaningful; the caller sets
+// it when linking the subtree in.
+// When the heights differ by more than one, middle and the shorter subtree
+// are hung off the spine of the taller one at the first node that is no
+// more than one taller than the shorter subtree, and the spine is rebalanced
+// on the way back up. This costs O(1 + the difference in heights).
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::join(
+    Node *left, Node *middle, Node *right)
+{
+    if (height(left) > height(right) + 1)
+    {
+        return joinRight(left, middle, right);
+    }
+    else if (height(right) > height(left) + 1)
+    {
+        return joinLeft(left, middle, right);
+    }
+
+    return linkNode(left, middle, right);
+}
+
+// Private Function: joinRight
+// Input: left, middle, right - As for join, with left the taller subtree by
+//                              more than one.
+// Output: Returns the root of a balanced subtree holding all the nodes.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::joinRight(
+    Node *left, Node *middle, Node *right)
+{
+    if (height(left->right) <= height(right) + 1)
+    {
+        left->right = linkNode(left->right, middle, right);
+    }
+    else
+    {
+        left->right = joinRight(left->right, middle, right);
+    }
+
+    left->right->parent = left;
+
+    return rebalance(left);
+}
+
+// Private Function: joinLeft
+// Input: left, middle, right - As for join, with right the taller subtree by
+//                              more than one.
+// Output: Returns the root of a balanced subtree holding all the nodes.
+// This is the mirror image of joinRight.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::joinLeft(
+    Node *left, Node *middle, Node *right)
+{
+    if (height(right->left) <= height(left) + 1)
+    {
+        right->left = linkNode(left, middle, right->left);
+    }
+    else
+    {
+        right->left = joinLeft(left, middle, right->left);
+    }
+
+    right->left->parent = right;
+
+    return rebalance(right);
+}
+
+// Private Function: joinWithoutMiddle
+// Input: left - A balanced subtree whose keys are all smaller than right's.
+//        right - A balanced subtree.
+// Output: Returns the root of a balanced subtree holding both.
+// The largest node of left is taken out and used as the middle node.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::joinWithoutMiddle(
+    Node *left, Node *right)
+{
+    if (left == NULL)
+    {
+        return right;
+    }
+
+    Node *last = NULL;
+    Node *rest = splitLast(left, last);
+
+    return join(rest, last, right);
+}
+
+// Private Function: splitLast
+// Input: node - The root of a non-empty balanced subtree.
+//        last - Set to the node with the largest key.
+// Output: Returns the root of the balanced subtree of the other nodes.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::splitLast(
+    Node *node, Node *&last)
+{
+    if (node->right == NULL)
+    {
+        last = node;
+        return node->left;
+    }
+
+    Node *rest = splitLast(node->right, last);
+
+    return join(node->left, node, rest);
+}
+
+// Private Function: split
+// Input: node - The root of a balanced subtree.
+//        key - The key to split at.
+//        left - Set to a balanced subtree of the keys smaller than key.
+//        found - Set to the node whose key is equivalent to key, or NULL.
+//        right - Set to a balanced subtree of the keys larger than key.
+// Output: None.
+// On the way back up from the search for key, every node passed becomes the
+// middle of a join with the pieces on its side. The joins' costs add up to
+// O(log n), since each is proportional to a difference in heights and the
+// heights grow on the way up.
+template <class Key, class Value, class Compare, class Statistics>
+template <class K>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::split(
+    Node *node, const K &key, Node *&left, Node *&found, Node *&right)
+{
+    if (node == NULL)
+    {
+        left = NULL;
+        found = NULL;
+        right = NULL;
+        return;
+    }
+
+    Node *nodeLeft = node->left;
+    Node *nodeRight = node->right;
+
+    if (m_compare(key, node->key))
+    {
+        split(nodeLeft, key, left, found, right);
+        right = join(right, node, nodeRight);
+    }
+    else if (m_compare(node->key, key))
+    {
+        split(nodeRight, key, left, found, right);
+        left = join(nodeLeft, node, left);
+    }
+    else
+    {
+        left = nodeLeft;
+        found = node;
+        right = nodeRight;
+    }
+}
+
+// Private Function: unionNodes
+// Input: node - The root of a subtree of this tree.
+//        otherNode - The root of a subtree of the other tree.
+//        slots - Memory for a copy of each node of the other tree, indexed
+//                by the node's rank there.
+//        used - Set to 1 for each slot that receives a copy.
+//        firstRank - The rank in the other tree of otherNode's smallest key.
+//        forkDepth - How many more levels of the operation may start threads.
+// Output: Returns the root of a balanced subtree of both subtrees' keys.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::unionNodes(
+    Node *node, Node *otherNode, void **slots, char *used, size_t firstRank,
+    int forkDepth)
+{
+    if (otherNode == NULL)
+    {
+        return node;
+    }
+
+    if (node == NULL)
+    {
+        return copyNodes(otherNode, slots, used, firstRank, forkDepth);
+    }
+
+    bool parallel = forkDepth > 0 &&
+                    size(node) + size(otherNode) >= PARALLEL_CUTOFF;
+    size_t otherRank = firstRank + size(otherNode->left);
+    Node *left = NULL;
+    Node *found = NULL;
+    Node *right = NULL;
+
+    split(node, otherNode->key, left, found, right);
+
+    forkJoin(parallel, [&]()
+    {
+        left = unionNodes(left, otherNode->left, slots, used, firstRank,
+                          forkDepth - parallel);
+    }, [&]()
+    {
+        right = unionNodes(right, otherNode->right, slots, used,
+                           otherRank + 1, forkDepth - parallel);
+    });
+
+    // Only keys that were not here already need a copy:
+    if (found == NULL)
+    {
+        found = new (slots[otherRank])
+                    Node(static_cast<const Node &>(*otherNode));
+        used[otherRank] = 1;
+    }
+
+    return join(left, found, right);
+}
+
+// Private Function: copyNodes
+// Input: otherNode - The root of a subtree of the other tree.
+//        slots, used, firstRank, forkDepth - As for unionNodes.
+// Output: Returns the root of a copy of the subtree with the same shape.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::copyNodes(
+    Node *otherNode, void **slots, char *used, size_t firstRank, int forkDepth)
+{
+    if (otherNode == NULL)
+    {
+        return NULL;
+    }
+
+    bool parallel = forkDepth > 0 && size(otherNode) >= PARALLEL_CUTOFF;
+    size_t otherRank = firstRank + size(otherNode->left);
+    Node *left = NULL;
+    Node *right = NULL;
+
+    forkJoin(parallel, [&]()
+    {
+        left = copyNodes(otherNode->left, slots, used, firstRank,
+                         forkDepth - parallel);
+    }, [&]()
+    {
+        right = copyNodes(otherNode->right, slots, used, otherRank + 1,
+                          forkDepth - parallel);
+    });
+
+    Node *copy = new (slots[otherRank])
+                     Node(static_cast<const Node &>(*otherNode));
+
+    used[otherRank] = 1;
+
+    return linkNode(left, copy, right);
+}
+
+// Private Function: intersectNodes
+// Input: node - The root of a subtree of this tree.
+//        otherNode - The root of a subtree of the other tree.
+//        discarded - The list the removed nodes are added to.
+//        forkDepth - How many more levels of the operation may start threads.
+// Output: Returns the root of a balanced subtree of the keys of node's
+//          subtree that are also in otherNode's.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::intersectNodes(
+    Node *node, Node *otherNode, NodeList &discarded, int forkDepth)
+{
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    if (otherNode == NULL)
+    {
+        discard(discarded, node);
+        return NULL;
+    }
+
+    bool parallel = forkDepth > 0 &&
+                    size(node) + size(otherNode) >= PARALLEL_CUTOFF;
+    NodeList rightDiscarded = { NULL, NULL };
+    Node *left = NULL;
+    Node *found = NULL;
+    Node *right = NULL;
+
+    split(node, otherNode->key, left, found, right);
+
+    forkJoin(parallel, [&]()
+    {
+        left = intersectNodes(left, otherNode->left, discarded,
+                              forkDepth - parallel);
+    }, [&]()
+    {
+        right = intersectNodes(right, otherNode->right, rightDiscarded,
+                               forkDepth - parallel);
+    });
+
+    appendList(discarded, rightDiscarded);
+
+    if (found != NULL)
+    {
+        return join(left, found, right);
+    }
+
+    return joinWithoutMiddle(left, right);
+}
+
+// Private Function: differenceNodes
+// Input: node - The root of a subtree of this tree.
+//        otherNode - The root of a subtree of the other tree.
+//        discarded - The list the removed nodes are added to.
+//        forkDepth - How many more levels of the operation may start threads.
+// Output: Returns the root of a balanced subtree of the keys of node's
+//          subtree that are not in otherNode's.
+template <class Key, class Value, class Compare, class Statistics>
+BinarySearchTreeNode<Key, Value> *
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::differenceNodes(
+    Node *node, Node *otherNode, NodeList &discarded, int forkDepth)
+{
+    if (node == NULL || otherNode == NULL)
+    {
+        return node;
+    }
+
+    bool parallel = forkDepth > 0 &&
+                    size(node) + size(otherNode) >= PARALLEL_CUTOFF;
+    NodeList rightDiscarded = { NULL, NULL };
+    Node *left = NULL;
+    Node *found = NULL;
+    Node *right = NULL;
+
+    split(node, otherNode->key, left, found, right);
+
+    forkJoin(parallel, [&]()
+    {
+        left = differenceNodes(left, otherNode->left, discarded,
+                               forkDepth - parallel);
+    }, [&]()
+    {
+        right = differenceNodes(right, otherNode->right, rightDiscarded,
+                                forkDepth - parallel);
+    });
+
+    appendList(discarded, rightDiscarded);
+
+    if (found != NULL)
+    {
+        found->left = NULL;
+        found->right = NULL;
+        discard(discarded, found);
+    }
+
+    return joinWithoutMiddle(left, right);
+}
+
+// Private Function: discard
+// Input: list - A list of subtrees to be freed.
+//        subtree - The root of a subtree no longer linked into the tree.
+// Output: None.
+template <class Key, class Value, class Compare, class Statistics>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::discard(
+    NodeList &list, Node *subtree)
+{
+    subtree->parent = NULL;
+
+    if (list.tail != NULL)
+    {
+        list.tail->parent = subtree;
+    }
+    else
+    {
+        list.head = subtree;
+    }
+
+    list.tail = subtree;
+}
+
+// Private Function: appendList
+// Input: list - A list of subtrees to be freed.
+//        other - Another such list, which is moved to the end of list.
+// Output: None.
+template <class Key, class Value, class Compare, class Statistics>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::appendList(
+    NodeList &list, NodeList &other)
+{
+    if (other.head == NULL)
+    {
+        return;
+    }
+
+    if (list.tail != NULL)
+    {
+        list.tail->parent = other.head;
+    }
+    else
+    {
+        list.head = other.head;
+    }
+
+    list.tail = other.tail;
+    other.head = NULL;
+    other.tail = NULL;
+}
+
+// Private Function: releaseList
+// Input: list - A list of subtrees to be freed.
+// Output: None.
+// Destroys every node of every subtree and gives its memory back to the
+// allocator. This runs on one thread, since the allocator is not shared.
+template <class Key, class Value, class Compare, class Statistics>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::releaseList(
+    NodeList &list)
+{
+    Node *subtree = list.head;
+
+    while (subtree != NULL)
+    {
+        Node *next = subtree->parent;
+
+        destroyNodes(subtree, true);
+        subtree = next;
+    }
+
+    list.head = NULL;
+    list.tail = NULL;
+}
+
+// Private Function: parallelDepth
+// Input: None.
+// Output: The number of levels of a set operation that may start a thread,
+//          enough to give every hardware thread a share of the work.
+template <class Key, class Value, class Compare, class Statistics>
+int BasicBinarySearchTree<Key, Value, Compare, Statistics>::parallelDepth()
+{
+    unsigned hardwareThreads = thread::hardware_concurrency();
+    int depth = 0;
+
+    for (unsigned threads = 1; threads < hardwareThreads; threads *= 2)
+    {
+        ++depth;
+    }
+
+    return depth;
+}
+
+// Private Function: forkJoin
+// Input: parallel - Whether to run the tasks at the same time.
+//        leftTask - A function taking no arguments.
+//        rightTask - A function taking no arguments, independent of leftTask.
+// Output: None, once both tasks have finished.
+// The left task gets a new thread and the right one runs on this thread.
+// Threads are only started for the top levels of an operation, so a whole
+// operation starts fewer threads than there are hardware threads, and a pool
+// would not save anything.
+template <class Key, class Value, class Compare, class Statistics>
+template <class LeftTask, class RightTask>
+void
+BasicBinarySearchTree<Key, Value, Compare, Statistics>::forkJoin(
+    bool parallel, LeftTask leftTask, RightTask rightTask)
+{
+    if (parallel)
+    {
+        thread helper(leftTask);
+
+        rightTask();
+        helper.join();
+    }
+    else
+    {
+        leftTask();
+        rightTask();
+    }
+}
+
+// Private Function: measureMinimumDepth
+// Input: root - The root node of the tree.
+// Output: Returns the number of nodes traversed along the shortest path to a
+// leaf node.
+// A breadth-first search finds the closest leaf first, but its queue grows
+// with the width of the tree. This depth-first search instead keeps only the
+// right children still to visit on the current path, which fit in a fixed
+// array, and never descends to where it could not beat the shortest path
+// found so far.
+template <class Key, class Value, class Compare, class Statistics>
+int BasicBinarySearchTree<Key, Value, Compare, Statistics>::measureMinimumDepth(
+    Node *root)
+{
+    Node *pendingNodes[MAX_HEIGHT];
+    int pendingDepths[MAX_HEIGHT];
+    int pendingCount = 0;
+    int shortest = MAX_HEIGHT + 1;
+    Node *node = root;
+    int depth = 0; // Number of nodes above node.
+
+    while (true)
+    {
+        // A missing child ends a path of depth nodes:
+        if (node == NULL && depth < shortest)
+        {
+            shortest = depth;
+        }
+
+        // Go down to the left while a shorter path is still possible:
+        if (node != NULL && depth + 1 < shortest)
+        {
+            pendingNodes[pendingCount] = node->right;
+            pendingDepths[pendingCount] = depth + 1;
+            ++pendingCount;
+            node = node->left;
+            ++depth;
+        }
+        // Otherwise continue with the deepest right child not yet visited:
+        else if (pendingCount > 0)
+        {
+            --pendingCount;
+            node = pendingNodes[pendingCount];
+            depth = pendingDepths[pendingCount];
+        }
+        else
+        {
+            return shortest;
+        }
+    }
+}
+
+// Private Function: visitDepthFirst
+// Input: order - IN_ORDER, PRE_ORDER or POST_ORDER.
+//        visitor - Called as visitor(key, level) for every node.
+// Output: None.
+// Walks the tree without a stack by following the parent links back up.
+// Where we came from tells which step is next: arriving from the parent,
+// the left subtree is still to be visited; arriving from the left child,
+// the right subtree is; arriving from the right child, the node is done.
+// Each node is visited at the step its order calls for.
+template <class Key, class Value, class Compare, class Statistics>
+template <class Function>
+void BasicBinarySearchTree<Key, Value, Compare, Statistics>::visitDepthFirst(
+    TraversalOrder order, Function visitor)
+{
+    Node *node = m_root;
+    Node *previous = NULL;
+    int level = 0;
+
+    while (node != NULL)
+    {
+        Node *next = NULL;
+
+        if (previous == node->parent)
+        {
+            if (order == PRE_ORDER)
+            {
+                visitor(static_cast<const Key &>(node->key), level);
+            }
+
+            next = node->left;
+
+            // With no left subtree, carry straight on to the right one:
+            if (next == NULL)
+            {
+                if (order == IN_ORDER)
+                {
+                    visitor(static_cast<const Key &>(node->key), level);
+                }
+
+                next = node->right;
+            }
+        }
+        else if (previous == node->left)
+        {
+            if (order == IN_ORDER)
+            {
+                visitor(static_cast<const Key &>(node->key), level);
+            }
+
+            next = node->right;
+        }
+
+        // Both subtrees are done, so go back up:
+        if (next == NULL)
+        {
+            if (order == POST_ORDER)
+            {
+                visitor(static_cast<const Key &>(node->key), level);
+            }
+
+            next = node->parent;
+            --level;
+        }
+        else
+        {
+            ++level;
+        }
+
+        previous = node;
+        node = next;
+    }
+}
+
 #endif // BINARY_SEARCH_TREE_H
@@ -0,0 +1,417 @@
+/*  File: ConcurrentBenchmark.cpp
+ *  This file contains driver code for the ConcurrentBinarySearchTree class.
+ *  It first runs a stress test in which writer threads keep inserting and
+ *  removing keys while reader threads check that keys which are never removed
+ *  are always found and keys which are never inserted are never found. It
+ *  then measures the combined throughput of 1 to N threads at several mixes
+ *  of searches and writes, next to a BinarySearchTree guarded by a single
+ *  mutex, which is what sharing the tree between threads required before.
+ *  Finally it compares taking point-in-time snapshots for analytics from a
+ *  VersionedBinarySearchTree with copying a locked BinarySearchTree, while
+ *  writers keep changing the tree.
+ *
+ *  Compile with -std=c++11 -O2 -pthread.
+ */
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "BinarySearchTree.h"
+#include "ConcurrentBinarySearchTree.h"
+#include "PersistentBinarySearchTree.h"
+
+using namespace std;
+
+// Data Structure: LockedBinarySearchTree
+// A BinarySearchTree behind one mutex, for comparison.
+class LockedBinarySearchTree
+{
+    public:
+        void insertNode(int key)
+        {
+            lock_guard<mutex> lock(m_lock);
+            m_tree.insertNode(key);
+        }
+
+        void removeNode(int key)
+        {
+            lock_guard<mutex> lock(m_lock);
+            m_tree.removeNode(key);
+        }
+
+        bool containsNode(int key)
+        {
+            lock_guard<mutex> lock(m_lock);
+            return m_tree.containsNode(key);
+        }
+
+        // The consistent snapshot this tree allows: a copy of every key.
+        void copyKeys(vector<int> &keys)
+        {
+            lock_guard<mutex> lock(m_lock);
+            keys.assign(m_tree.begin(), m_tree.end());
+        }
+
+    private:
+        mutex m_lock;
+        BinarySearchTree m_tree;
+};
+
+// Function stressTest
+// Input: readerCount - The number of threads searching the tree.
+//        writerCount - The number of threads changing the tree.
+//        seconds - How long to run.
+// Output: Returns the number of wrong answers seen by the readers.
+// Multiples of 4 are inserted up front and never removed. Writers churn keys
+// that are 1 modulo 4, so the tree keeps being rebalanced around the stable
+// keys. Keys that are 2 or 3 modulo 4 are never inserted.
+size_t stressTest(int readerCount, int writerCount, int seconds)
+{
+    const int KEY_RANGE = 1 << 16;
+    ConcurrentBinarySearchTree<int> tree;
+    atomic<bool> stop(false);
+    atomic<size_t> errors(0);
+    atomic<size_t> searches(0);
+    vector<thread> threads;
+
+    for (int key = 0; key < KEY_RANGE; key += 4)
+    {
+        tree.insertNode(key);
+    }
+
+    for (int i = 0; i < writerCount; ++i)
+    {
+        threads.push_back(thread([&tree, &stop, i]()
+        {
+            mt19937 generator(i);
+            uniform_int_distribution<int> distribution(0, KEY_RANGE / 4 - 1);
+
+            while (!stop.load())
+            {
+                int key = 4 * distribution(generator) + 1;
+
+                if (generator() & 1)
+                {
+                    tree.insertNode(key);
+                }
+                else
+                {
+                    tree.removeNode(key);
+                }
+            }
+        }));
+    }
+
+    for (int i = 0; i < readerCount; ++i)
+    {
+        threads.push_back(thread([&tree, &stop, &errors, &searches, i]()
+        {
+            mt19937 generator(1000 + i);
+            uniform_int_distribution<int> distribution(0, KEY_RANGE - 1);
+            size_t count = 0;
+
+            while (!stop.load())
+            {
+                int key = distribution(generator);
+                bool found = tree.containsNode(key);
+
+                if ((key % 4 == 0 && !found) || (key % 4 >= 2 && found))
+                {
+                    ++errors;
+                }
+
+                ++count;
+            }
+
+            searches += count;
+        }));
+    }
+
+    this_thread::sleep_for(chrono::seconds(seconds));
+    stop.store(true);
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+
+    cout << "Stress test: " << readerCount << " readers, " << writerCount
+         << " writers, " << searches.load() << " searches, "
+         << errors.load() << " wrong answers, " << tree.retiredNodeCount()
+         << " nodes awaiting reclamation" << endl;
+
+    return errors.load();
+}
+
+// Function measureThroughput
+// Input: tree - The tree to run the workload on, preloaded with keys.
+//        threadCount - The number of threads running the workload.
+//        readPercent - The percentage of operations that are searches; the
+//                      rest are split evenly between insertions and removals.
+//        keyRange - Keys are drawn uniformly from [0, keyRange).
+// Output: Returns the combined number of operations per second.
+template <class Tree>
+double measureThroughput(Tree &tree, int threadCount, int readPercent,
+                         int keyRange)
+{
+    const size_t OPERATIONS_PER_THREAD = 500000;
+    vector<thread> threads;
+    atomic<size_t> found(0);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    for (int i = 0; i < threadCount; ++i)
+    {
+        threads.push_back(thread([&tree, &found, readPercent, keyRange, i]()
+        {
+            mt19937 generator(i);
+            uniform_int_distribution<int> keys(0, keyRange - 1);
+            uniform_int_distribution<int> operations(0, 199);
+            size_t count = 0;
+
+            for (size_t j = 0; j < OPERATIONS_PER_THREAD; ++j)
+            {
+                int key = keys(generator);
+                int operation = operations(generator);
+
+                if (operation < 2 * readPercent)
+                {
+                    count += tree.containsNode(key);
+                }
+                else if (operation & 1)
+                {
+                    tree.insertNode(key);
+                }
+                else
+                {
+                    tree.removeNode(key);
+                }
+            }
+
+            // Using the answers keeps the searches from being optimized away:
+            found += count;
+        }));
+    }
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() -
+                                              start).count();
+
+    return threadCount * OPERATIONS_PER_THREAD / seconds;
+}
+
+// Function benchmarkScaling
+// Input: maxThreads - The largest number of threads to measure.
+// Output: Prints millions of operations per second for both trees at each
+//          thread count and read percentage.
+void benchmarkScaling(int maxThreads)
+{
+    const int KEY_RANGE = 1000000;
+    const int READ_PERCENTS[] = { 100, 95, 80, 50 };
+
+    for (size_t r = 0; r < sizeof(READ_PERCENTS) / sizeof(int); ++r)
+    {
+        // Doubling, but always ending with maxThreads itself, so machines
+        // with a core count that is not a power of two are measured in full:
+        for (int threadCount = 1; threadCount <= maxThreads;
+             threadCount = threadCount == maxThreads ? maxThreads + 1 :
+                           min(2 * threadCount, maxThreads))
+        {
+            ConcurrentBinarySearchTree<int> concurrentTree;
+            LockedBinarySearchTree lockedTree;
+
+            for (int key = 0; key < KEY_RANGE; key += 2)
+            {
+                concurrentTree.insertNode(key);
+                lockedTree.insertNode(key);
+            }
+
+            double concurrent = measureThroughput(concurrentTree, threadCount,
+                                                  READ_PERCENTS[r], KEY_RANGE);
+            double locked = measureThroughput(lockedTree, threadCount,
+                                              READ_PERCENTS[r], KEY_RANGE);
+
+            cout << READ_PERCENTS[r] << "% reads, " << threadCount
+                 << " threads: concurrent " << concurrent / 1e6
+                 << " Mops/s, single mutex " << locked / 1e6 << " Mops/s"
+                 << endl;
+        }
+    }
+}
+
+// Function takeSnapshot
+// Input: tree - The tree to take a snapshot of.
+//        keys - Scratch space for the copied keys.
+//        nanoseconds - Increased by the time taken to obtain the snapshot,
+//                      not counting the walk over it.
+// Output: Returns the sum of the keys in the snapshot, after walking it.
+long long takeSnapshot(LockedBinarySearchTree &tree, vector<int> &keys,
+                       long long &nanoseconds)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    long long sum = 0;
+
+    tree.copyKeys(keys);
+    nanoseconds += chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now() - start).count();
+
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        sum += keys[i];
+    }
+
+    return sum;
+}
+
+long long takeSnapshot(VersionedBinarySearchTree<int> &tree, vector<int> &,
+                       long long &nanoseconds)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    PersistentBinarySearchTree<int> snapshot = tree.snapshot();
+    long long sum = 0;
+
+    nanoseconds += chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now() - start).count();
+
+    snapshot.forEachInRange(INT_MIN, INT_MAX, [&sum](int key)
+    {
+        sum += key;
+    });
+
+    return sum;
+}
+
+// Function measureSnapshots
+// Input: name - A label for the printed line.
+//        tree - The tree to run the workload on, preloaded with keys.
+//        readerCount - The number of threads taking and walking snapshots.
+//        writerCount - The number of threads inserting and removing keys.
+//        keyRange - Writers draw keys uniformly from [0, keyRange).
+//        seconds - How long to run.
+// Output: Prints the number of snapshots taken and walked per second, the
+//          average time to obtain one, and the writers' throughput.
+template <class Tree>
+void measureSnapshots(const char *name, Tree &tree, int readerCount,
+                      int writerCount, int keyRange, double seconds)
+{
+    atomic<bool> stop(false);
+    atomic<size_t> snapshots(0);
+    atomic<size_t> writes(0);
+    atomic<long long> checksum(0);
+    atomic<long long> obtainNanoseconds(0);
+    vector<thread> threads;
+
+    for (int i = 0; i < writerCount; ++i)
+    {
+        threads.push_back(thread([&tree, &stop, &writes, keyRange, i]()
+        {
+            mt19937 generator(i);
+            uniform_int_distribution<int> keys(0, keyRange - 1);
+            size_t count = 0;
+
+            while (!stop.load())
+            {
+                int key = keys(generator);
+
+                if (generator() & 1)
+                {
+                    tree.insertNode(key);
+                }
+                else
+                {
+                    tree.removeNode(key);
+                }
+
+                ++count;
+            }
+
+            writes += count;
+        }));
+    }
+
+    for (int i = 0; i < readerCount; ++i)
+    {
+        threads.push_back(thread([&tree, &stop, &snapshots, &checksum,
+                                  &obtainNanoseconds]()
+        {
+            vector<int> keys;
+            size_t count = 0;
+            long long nanoseconds = 0;
+
+            while (!stop.load())
+            {
+                checksum += takeSnapshot(tree, keys, nanoseconds);
+                ++count;
+            }
+
+            snapshots += count;
+            obtainNanoseconds += nanoseconds;
+        }));
+    }
+
+    this_thread::sleep_for(chrono::duration<double>(seconds));
+    stop.store(true);
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+
+    cout << name << ": " << snapshots.load() / seconds
+         << " snapshots/s taken and walked, "
+         << obtainNanoseconds.load() / 1e3 / max<size_t>(1, snapshots.load())
+         << " us to obtain each, writers " << writes.load() / seconds / 1e6
+         << " Mops/s" << endl;
+}
+
+// Function benchmarkSnapshots
+// Input: keyCount - The number of keys in the tree.
+//        readerCount - The number of threads taking snapshots.
+//        writerCount - The number of threads changing the tree.
+// Output: Prints the results of measureSnapshots for both trees.
+void benchmarkSnapshots(int keyCount, int readerCount, int writerCount)
+{
+    VersionedBinarySearchTree<int> versionedTree;
+    LockedBinarySearchTree lockedTree;
+
+    for (int key = 0; key < 2 * keyCount; key += 2)
+    {
+        versionedTree.insertNode(key);
+        lockedTree.insertNode(key);
+    }
+
+    cout << keyCount << " keys, " << readerCount << " readers, "
+         << writerCount << " writers:" << endl;
+    measureSnapshots("  versioned snapshot", versionedTree, readerCount,
+                     writerCount, 2 * keyCount, 3);
+    measureSnapshots("  copy under lock", lockedTree, readerCount,
+                     writerCount, 2 * keyCount, 3);
+}
+
+int main()
+{
+    int cores = thread::hardware_concurrency();
+
+    if (cores < 2)
+    {
+        cores = 2;
+    }
+
+    size_t errors = stressTest(cores, 2, 5);
+
+    benchmarkScaling(cores);
+    benchmarkSnapshots(100000, 1, 1);
+    benchmarkSnapshots(1000000, 2, 2);
+
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,590 @@
+/*  File: ConcurrentBinarySearchTree.h
+ *  This file contains the declaration and implementation of the
+ *  ConcurrentBinarySearchTree class template.
+ *  A ConcurrentBinarySearchTree is an AVL tree of keys that many threads can
+ *  use at once without a global lock. Searches never take a lock or wait for
+ *  a writer; insertions and removals are serialized by a mutex among
+ *  themselves only.
+ *
+ *  This works because published nodes are never modified. A writer copies
+ *  the nodes on the path from the root to the change (O(log n) of them),
+ *  builds the new, rebalanced path out of fresh nodes that share all other
+ *  subtrees with the old tree, and then swings the atomic root pointer to the
+ *  new path. A reader that loaded the old root keeps seeing a complete,
+ *  consistent tree.
+ *
+ *  The replaced nodes cannot be freed while some reader may still be walking
+ *  them, so they are reclaimed by epochs. Each search announces the global
+ *  epoch in a reader slot before loading the root and clears it afterwards.
+ *  Every write retires its replaced nodes tagged with the epoch at which they
+ *  became unreachable and then advances the epoch. A retired node is freed
+ *  once every announced epoch is newer than its tag, because any reader that
+ *  could still reach it must have announced an epoch no newer than the tag.
+ *  Searches never block as long as fewer than READER_SLOTS threads are
+ *  searching at the same moment.
+ *
+ *  Compile with -std=c++11 -pthread (or later).
+ */
+
+#ifndef CONCURRENT_BINARY_SEARCH_TREE_H
+#define CONCURRENT_BINARY_SEARCH_TREE_H
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include "NodeAllocator.h"
+
+using namespace std;
+
+// Data Structure: ConcurrentBinarySearchTree
+template <class Key, class Compare = less<Key> >
+class ConcurrentBinarySearchTree
+{
+    public:
+        static const size_t READER_SLOTS = 256;
+
+        ConcurrentBinarySearchTree(const Compare &compare = Compare());
+        ~ConcurrentBinarySearchTree();
+
+        void insertNode(const Key &key);
+        void removeNode(const Key &key);
+        bool containsNode(const Key &key);
+        size_t retiredNodeCount();
+
+    private:
+        // Data Structure: Node
+        // Nodes are immutable once constructed, so readers need no
+        // synchronization beyond loading the root.
+        struct Node
+        {
+            Node(const Key &newKey, int newHeight, Node *newLeft,
+                 Node *newRight)
+                : key(newKey), height(newHeight), left(newLeft),
+                  right(newRight)
+            {
+            }
+
+            const Key key;
+            const int height;
+            Node *const left;
+            Node *const right;
+        };
+
+        // A node that is no longer reachable from the root, and the epoch at
+        // which that happened:
+        struct RetiredNode
+        {
+            Node *node;
+            uint64_t epoch;
+        };
+
+        // Each slot sits on its own cache line so that readers on different
+        // threads do not slow each other down. An epoch of zero marks a free
+        // slot.
+        struct ReaderSlot
+        {
+            alignas(64) atomic<uint64_t> epoch;
+        };
+
+        static const int MAX_HEIGHT = 96;
+
+        // Copying would share, and later free twice, the same nodes:
+        ConcurrentBinarySearchTree(const ConcurrentBinarySearchTree &);
+        ConcurrentBinarySearchTree &operator=(
+            const ConcurrentBinarySearchTree &);
+
+        size_t enterRead();
+        void exitRead(size_t slot);
+        Node *insertKey(const Key &key, Node *node);
+        Node *removeKey(const Key &key, Node *node);
+        Node *removeSmallest(Node *node, Node *&smallest);
+        Node *makeNode(const Key &key, Node *left, Node *right);
+        Node *balance(const Key &key, Node *left, Node *right);
+        int height(Node *node);
+        void retire(Node *node);
+        void publish(Node *root);
+        void reclaim();
+        void freeNode(Node *node);
+
+        atomic<Node *> m_root;
+        atomic<uint64_t> m_epoch;
+        ReaderSlot m_readers[READER_SLOTS];
+
+        // Everything below is only touched by writers holding m_writeLock:
+        mutex m_writeLock;
+        NodeAllocator<Node> m_allocator;
+        vector<Node *> m_replaced;    // Replaced by the write in progress.
+        deque<RetiredNode> m_retired; // Oldest epoch first.
+        Compare m_compare;
+};
+
+
+////
+//// Public Functions:
+////
+
+template <class Key, class Compare>
+ConcurrentBinarySearchTree<Key, Compare>::ConcurrentBinarySearchTree(
+    const Compare &compare)
+    : m_root(NULL), m_epoch(1), m_compare(compare)
+{
+    for (size_t i = 0; i < READER_SLOTS; ++i)
+    {
+        m_readers[i].epoch.store(0);
+    }
+}
+
+// The destructor must not run while other threads still use the tree.
+// Nodes reachable from the root and retired nodes are disjoint, so each node
+// is destroyed exactly once.
+template <class Key, class Compare>
+ConcurrentBinarySearchTree<Key, Compare>::~ConcurrentBinarySearchTree()
+{
+    Node *stack[MAX_HEIGHT + 1];
+    int depth = 0;
+
+    if (m_root.load() != NULL)
+    {
+        stack[depth++] = m_root.load();
+    }
+
+    // Taking a node off the stack and pushing its children leaves at most
+    // one pending sibling per level, so the stack stays within the height:
+    while (depth > 0)
+    {
+        Node *node = stack[--depth];
+
+        if (node->left != NULL)
+        {
+            stack[depth++] = node->left;
+        }
+
+        if (node->right != NULL)
+        {
+            stack[depth++] = node->right;
+        }
+
+        node->~Node();
+    }
+
+    for (size_t i = 0; i < m_retired.size(); ++i)
+    {
+        m_retired[i].node->~Node();
+    }
+
+    m_allocator.releaseAll();
+}
+
+// Public Function: insertNode
+// Input: key - Key to be added to the tree.
+// Output: None.
+// Runs concurrently with any number of containsNode calls, but waits for
+// other insertions and removals.
+template <class Key, class Compare>
+void ConcurrentBinarySearchTree<Key, Compare>::insertNode(const Key &key)
+{
+    lock_guard<mutex> lock(m_writeLock);
+    Node *root = m_root.load(memory_order_relaxed);
+    Node *newRoot = insertKey(key, root);
+
+    if (newRoot != root)
+    {
+        publish(newRoot);
+    }
+}
+
+// Public Function: removeNode
+// Input: key - Key indicating which node to remove.
+// Output: None.
+// Runs concurrently with any number of containsNode calls, but waits for
+// other insertions and removals.
+template <class Key, class Compare>
+void ConcurrentBinarySearchTree<Key, Compare>::removeNode(const Key &key)
+{
+    lock_guard<mutex> lock(m_writeLock);
+    Node *root = m_root.load(memory_order_relaxed);
+    Node *newRoot = removeKey(key, root);
+
+    if (newRoot != root)
+    {
+        publish(newRoot);
+    }
+}
+
+// Public Function: containsNode
+// Input: key - The key to search for in the tree.
+// Output: Returns true if the tree contains the key, otherwise false.
+// Never blocks. The answer reflects the tree as it was when the search
+// loaded the root; writes that finish later are not seen.
+template <class Key, class Compare>
+bool ConcurrentBinarySearchTree<Key, Compare>::containsNode(const Key &key)
+{
+    size_t slot = enterRead();
+    Node *node = m_root.load();
+    bool found = false;
+
+    while (node != NULL)
+    {
+        bool goLeft = m_compare(key, node->key);
+        bool goRight = m_compare(node->key, key);
+
+        if (!goLeft && !goRight)
+        {
+            found = true;
+            break;
+        }
+
+        node = (goRight ? node->right : node->left);
+    }
+
+    exitRead(slot);
+
+    return found;
+}
+
+// Public Function: retiredNodeCount
+// Input: None.
+// Output: The number of replaced nodes still waiting for readers to finish
+//          before they can be freed.
+template <class Key, class Compare>
+size_t ConcurrentBinarySearchTree<Key, Compare>::retiredNodeCount()
+{
+    lock_guard<mutex> lock(m_writeLock);
+
+    return m_retired.size();
+}
+
+
+////
+//// Private functions:
+////
+
+// Private Function: enterRead
+// Input: None.
+// Output: Returns the index of the reader slot claimed by this search.
+// Each thread starts looking at its own slot, chosen once by hashing its id,
+// so the slot's cache line normally stays with that thread. The slot is
+// claimed with a compare-and-swap so that two threads that hash to the same
+// slot simply move on to the next free one.
+template <class Key, class Compare>
+size_t ConcurrentBinarySearchTree<Key, Compare>::enterRead()
+{
+    static thread_local size_t preferredSlot =
+        hash<thread::id>()(this_thread::get_id()) % READER_SLOTS;
+    size_t slot = preferredSlot;
+    uint64_t epoch = m_epoch.load();
+
+    for (;;)
+    {
+        uint64_t freeEpoch = 0;
+
+        if (m_readers[slot].epoch.compare_exchange_strong(freeEpoch, epoch))
+        {
+            return slot;
+        }
+
+        slot = (slot + 1) % READER_SLOTS;
+    }
+}
+
+// Private Function: exitRead
+// Input: slot - The slot returned by enterRead.
+// Output: None.
+template <class Key, class Compare>
+void ConcurrentBinarySearchTree<Key, Compare>::exitRead(size_t slot)
+{
+    m_readers[slot].epoch.store(0, memory_order_release);
+}
+
+// Private Function: insertKey
+// Input: key - Key to be added to the subtree.
+//        node - The root of the subtree.
+// Output: Returns the root of a subtree that also contains the key. If the key
+//          was already present this is node itself, and nothing was copied.
+// The nodes on the path to the new leaf are replaced by rebalanced copies.
+template <class Key, class Compare>
+typename ConcurrentBinarySearchTree<Key, Compare>::Node *
+ConcurrentBinarySearchTree<Key, Compare>::insertKey(const Key &key, Node *node)
+{
+    if (node == NULL)
+    {
+        return makeNode(key, NULL, NULL);
+    }
+
+    if (m_compare(key, node->key))
+    {
+        Node *left = insertKey(key, node->left);
+
+        if (left == node->left)
+        {
+            return node;
+        }
+
+        retire(node);
+        return balance(node->key, left, node->right);
+    }
+    else if (m_compare(node->key, key))
+    {
+        Node *right = insertKey(key, node->right);
+
+        if (right == node->right)
+        {
+            return node;
+        }
+
+        retire(node);
+        return balance(node->key, node->left, right);
+    }
+    else
+    {
+        return node;
+    }
+}
+
+// Private Function: removeKey
+// Input: key - Key to be removed from the subtree.
+//        node - The root of the subtree.
+// Output: Returns the root of a subtree without the key. If the key was not
+//          present this is node itself, and nothing was copied.
+template <class Key, class Compare>
+typename ConcurrentBinarySearchTree<Key, Compare>::Node *
+ConcurrentBinarySearchTree<Key, Compare>::removeKey(const Key &key, Node *node)
+{
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    if (m_compare(key, node->key))
+    {
+        Node *left = removeKey(key, node->left);
+
+        if (left == node->left)
+        {
+            return node;
+        }
+
+        retire(node);
+        return balance(node->key, left, node->right);
+    }
+    else if (m_compare(node->key, key))
+    {
+        Node *right = removeKey(key, node->right);
+
+        if (right == node->right)
+        {
+            return node;
+        }
+
+        retire(node);
+        return balance(node->key, node->left, right);
+    }
+
+    // This node contains the key. A missing child makes it easy:
+    retire(node);
+
+    if (node->left == NULL)
+    {
+        return node->right;
+    }
+    else if (node->right == NULL)
+    {
+        return node->left;
+    }
+
+    // Otherwise the successor's key takes the place of the removed key:
+    Node *successor;
+    Node *right = removeSmallest(node->right, successor);
+
+    return balance(successor->key, node->left, right);
+}
+
+// Private Function: removeSmallest
+// Input: node - The root of a non-empty subtree.
+//        smallest - Set to the node with the smallest key in the subtree.
+// Output: Returns the root of the subtree without its smallest node.
+template <class Key, class Compare>
+typename ConcurrentBinarySearchTree<Key, Compare>::Node *
+ConcurrentBinarySearchTree<Key, Compare>::removeSmallest(Node *node,
+                                                         Node *&smallest)
+{
+    retire(node);
+
+    if (node->left == NULL)
+    {
+        smallest = node;
+        return node->right;
+    }
+
+    Node *left = removeSmallest(node->left, smallest);
+
+    return balance(node->key, left, node->right);
+}
+
+// Private Function: makeNode
+// Input: key - The key of the new node.
+//        left, right - The children of the new node.
+// Output: Returns a new node whose height is computed from its children.
+template <class Key, class Compare>
+typename ConcurrentBinarySearchTree<Key, Compare>::Node *
+ConcurrentBinarySearchTree<Key, Compare>::makeNode(const Key &key, Node *left,
+                                                   Node *right)
+{
+    int leftHeight = height(left);
+    int rightHeight = height(right);
+    int newHeight = 1 + (leftHeight > rightHeight ? leftHeight : rightHeight);
+
+    return new (m_allocator.allocate()) Node(key, newHeight, left, right);
+}
+
+// Private Function: balance
+// Input: key - The key of the node to build.
+//        left, right - Balanced subtrees whose heights differ by at most two.
+// Output: Returns the root of a balanced subtree holding left, key and right.
+// This is the AVL rebalancing step written without modifying any node: a
+// rotation builds new nodes for the two or three nodes it would move, and the
+// node it takes apart is retired.
+template <class Key, class Compare>
+typename ConcurrentBinarySearchTree<Key, Compare>::Node *
+ConcurrentBinarySearchTree<Key, Compare>::balance(const Key &key, Node *left,
+                                                  Node *right)
+{
+    int leftHeight = height(left);
+    int rightHeight = height(right);
+
+    // Left subtree is too tall:
+    if (leftHeight > rightHeight + 1)
+    {
+        retire(left);
+
+        // Left-left case, a single right rotation:
+        if (height(left->left) >= height(left->right))
+        {
+            return makeNode(left->key, left->left,
+                            makeNode(key, left->right, right));
+        }
+
+        // Left-right case, a double rotation:
+        Node *pivot = left->right;
+
+        retire(pivot);
+        return makeNode(pivot->key,
+                        makeNode(left->key, left->left, pivot->left),
+                        makeNode(key, pivot->right, right));
+    }
+    // Right subtree is too tall:
+    else if (rightHeight > leftHeight + 1)
+    {
+        retire(right);
+
+        // Right-right case, a single left rotation:
+        if (height(right->right) >= height(right->left))
+        {
+            return makeNode(right->key, makeNode(key, left, right->left),
+                            right->right);
+        }
+
+        // Right-left case, a double rotation:
+        Node *pivot = right->left;
+
+        retire(pivot);
+        return makeNode(pivot->key, makeNode(key, left, pivot->left),
+                        makeNode(right->key, pivot->right, right->right));
+    }
+
+    return makeNode(key, left, right);
+}
+
+// Private Function: height
+// Input: node - The root of a subtree.
+// Output: The height of the subtree, or zero if it is empty.
+template <class Key, class Compare>
+int ConcurrentBinarySearchTree<Key, Compare>::height(Node *node)
+{
+    if (node != NULL)
+    {
+        return node->height;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+// Private Function: retire
+// Input: node - A node that will not be part of the tree after this write.
+// Output: None.
+// The node may still be in use by readers, so it is only remembered here.
+template <class Key, class Compare>
+void ConcurrentBinarySearchTree<Key, Compare>::retire(Node *node)
+{
+    m_replaced.push_back(node);
+}
+
+// Private Function: publish
+// Input: root - The root of the tree produced by the current write.
+// Output: None.
+// Makes the new tree visible to readers, retires the nodes it replaced with
+// the current epoch, advances the epoch and frees whatever is now safe.
+template <class Key, class Compare>
+void ConcurrentBinarySearchTree<Key, Compare>::publish(Node *root)
+{
+    m_root.store(root);
+
+    uint64_t epoch = m_epoch.fetch_add(1);
+
+    for (size_t i = 0; i < m_replaced.size(); ++i)
+    {
+        RetiredNode retired = { m_replaced[i], epoch };
+        m_retired.push_back(retired);
+    }
+
+    m_replaced.clear();
+    reclaim();
+}
+
+// Private Function: reclaim
+// Input: None.
+// Output: None.
+// Frees the retired nodes whose epoch is older than that of every search in
+// progress. A search that has not yet announced itself will load the current
+// root, from which no retired node is reachable.
+template <class Key, class Compare>
+void ConcurrentBinarySearchTree<Key, Compare>::reclaim()
+{
+    uint64_t oldestEpoch = m_epoch.load();
+
+    for (size_t i = 0; i < READER_SLOTS; ++i)
+    {
+        uint64_t epoch = m_readers[i].epoch.load();
+
+        if (epoch != 0 && epoch < oldestEpoch)
+        {
+            oldestEpoch = epoch;
+        }
+    }
+
+    while (!m_retired.empty() && m_retired.front().epoch < oldestEpoch)
+    {
+        freeNode(m_retired.front().node);
+        m_retired.pop_front();
+    }
+}
+
+// Private Function: freeNode
+// Input: node - A node no reader can reach any more.
+// Output: None.
+template <class Key, class Compare>
+void ConcurrentBinarySearchTree<Key, Compare>::freeNode(Node *node)
+{
+    node->~Node();
+    m_allocator.deallocate(node);
+}
+
+#endif // CONCURRENT_BINARY_SEARCH_TREE_H
@@ -0,0 +1,491 @@
+/*  File: FrozenBinarySearchTree.h
+ *  This file contains the declaration and implementation of the
+ *  FrozenBinarySearchTree class template.
+ *  A FrozenBinarySearchTree is an immutable copy of the keys of a
+ *  BinarySearchTree that is laid out for fast lookups rather than for
+ *  updates. The keys are stored in a single array in Eytzinger (breadth-first)
+ *  order: the root is at index 1 and the children of the key at index k are
+ *  at indices 2k and 2k+1. There are no child pointers to chase, the top
+ *  levels of the tree share a handful of cache lines, and the descent can be
+ *  written without branches and with the next levels prefetched.
+ *
+ *  A snapshot is created or refreshed with BinarySearchTree::freeze(), which
+ *  walks the tree in order and copies each key straight into its place in
+ *  the snapshot's storage. The storage is reused, so rebuilding after a
+ *  batch of writes costs one O(n) pass and no new allocations once the
+ *  snapshot is large enough.
+ *  Keys must be default constructible and copyable.
+ *
+ *  Since the layout has no pointers, a snapshot can also be saved to a file
+ *  and later mapped straight back into memory with loadMapped(), then
+ *  searched in place: the file is the array. Loading costs no pass over the
+ *  keys (other than the optional checksum check), pages are read from disk
+ *  only as searches touch them, and any number of processes mapping the
+ *  same file share one copy of it in the page cache. Saving and loading
+ *  need keys that can be copied byte by byte, such as integers, and a file
+ *  must be loaded with the same key type and ordering it was saved with.
+ *
+ *  The file holds a 64-byte header followed by the array exactly as it is
+ *  in memory, from the unused slot 0 up to the last key. The header records
+ *  a magic string, the format version, the key size, a byte order marker,
+ *  the number of keys, and a checksum of the keys, all of which loadMapped()
+ *  checks before using the file.
+ */
+
+#ifndef FROZEN_BINARY_SEARCH_TREE_H
+#define FROZEN_BINARY_SEARCH_TREE_H
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+// Data Structure: FrozenBinarySearchTree
+template <class Key, class Compare = less<Key> >
+class FrozenBinarySearchTree
+{
+    public:
+        FrozenBinarySearchTree(const Compare &compare = Compare());
+        ~FrozenBinarySearchTree();
+
+        void rebuild(const vector<Key> &sortedKeys);
+        template <class NextKey>
+        void rebuild(size_t count, NextKey nextKey);
+        bool save(const char *path);
+        bool loadMapped(const char *path, bool verifyChecksum = true);
+        bool containsNode(const Key &key);
+        template <class K, class C = Compare,
+                  class = typename C::is_transparent>
+        bool containsNode(const K &key);
+        size_t size();
+
+    private:
+        // The number of keys that fit in one 64-byte cache line. Prefetching
+        // the key at index KEYS_PER_CACHE_LINE * k brings in the descendants
+        // of k that many levels down.
+        static const size_t KEYS_PER_CACHE_LINE =
+            sizeof(Key) < 64 ? 64 / sizeof(Key) : 1;
+
+        static const uint32_t SNAPSHOT_VERSION = 1;
+        static const uint32_t BYTE_ORDER_MARKER = 0x01020304;
+
+        // The first 64 bytes of a snapshot file. Being a whole cache line
+        // keeps the array after it aligned in the mapping.
+        struct SnapshotHeader
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t keySize;
+            uint32_t byteOrder;
+            uint32_t reserved;
+            uint64_t keyCount;
+            uint64_t checksum;
+            char padding[24];
+        };
+
+        // Copying would leave m_keys pointing into the other snapshot, or
+        // unmap the same file twice:
+        FrozenBinarySearchTree(const FrozenBinarySearchTree &);
+        FrozenBinarySearchTree &operator=(const FrozenBinarySearchTree &);
+
+        template <class K>
+        bool findKey(const K &key);
+        void unmap();
+        static uint64_t checksum(const char *data, size_t length);
+
+        vector<Key> m_storage; // Backing memory, padded for alignment.
+        Key *m_keys;           // Cache-line aligned; m_keys[1] is the root.
+        size_t m_size;
+        Compare m_compare;
+        void *m_mapping;       // The mapped file, or NULL if not mapped.
+        size_t m_mappingSize;
+};
+
+
+////
+//// Public Functions:
+////
+
+template <class Key, class Compare>
+FrozenBinarySearchTree<Key, Compare>::FrozenBinarySearchTree(
+    const Compare &compare)
+    : m_compare(compare)
+{
+    m_keys = NULL;
+    m_size = 0;
+    m_mapping = NULL;
+    m_mappingSize = 0;
+}
+
+template <class Key, class Compare>
+FrozenBinarySearchTree<Key, Compare>::~FrozenBinarySearchTree()
+{
+    unmap();
+}
+
+// Public Function: rebuild
+// Input: sortedKeys - The keys of the snapshot in strictly increasing order.
+// Output: None.
+// Replaces the contents of the snapshot.
+template <class Key, class Compare>
+void FrozenBinarySearchTree<Key, Compare>::rebuild(
+    const vector<Key> &sortedKeys)
+{
+    size_t i = 0;
+
+    rebuild(sortedKeys.size(),
+            [&]() -> const Key &
+            {
+                return sortedKeys[i++];
+            });
+}
+
+// Public Function: rebuild
+// Input: count - The number of keys of the snapshot.
+//        nextKey - A function that returns the next key each time it is
+//                  called, in strictly increasing order. It is called
+//                  exactly count times.
+// Output: None.
+// Replaces the contents of the snapshot. The implicit tree is walked in order
+// while the keys are read, so each key lands directly at its Eytzinger
+// position and the keys never need to be gathered anywhere else first.
+template <class Key, class Compare>
+template <class NextKey>
+void FrozenBinarySearchTree<Key, Compare>::rebuild(size_t count,
+                                                   NextKey nextKey)
+{
+    unmap();
+    m_size = count;
+
+    // One unused slot for index 0, the keys, and at most one cache line of
+    // padding to align m_keys. findKey prefetches past the end without
+    // touching the buffer, so nothing more is needed:
+    m_storage.resize(KEYS_PER_CACHE_LINE + m_size);
+
+    // Only key sizes that divide the cache line size can be aligned exactly;
+    // for others this just skips a few slots:
+    uintptr_t address = reinterpret_cast<uintptr_t>(&m_storage[0]);
+    size_t misalignment = (address % 64) / sizeof(Key);
+    m_keys = &m_storage[0] + (misalignment == 0 ? 0 :
+                              KEYS_PER_CACHE_LINE - misalignment);
+
+    if (m_size == 0)
+    {
+        return;
+    }
+
+    // Start at the left-most position of the implicit tree:
+    size_t position = 1;
+
+    while (2 * position <= m_size)
+    {
+        position = 2 * position;
+    }
+
+    for (size_t i = 0; i < m_size; ++i)
+    {
+        m_keys[position] = nextKey();
+
+        // Move to the in-order successor of position. If it has a right child
+        // the successor is the left-most position in that subtree:
+        if (2 * position + 1 <= m_size)
+        {
+            position = 2 * position + 1;
+
+            while (2 * position <= m_size)
+            {
+                position = 2 * position;
+            }
+        }
+        // Otherwise climb while we are a right child, then once more:
+        else
+        {
+            while (position & 1)
+            {
+                position >>= 1;
+            }
+
+            position >>= 1;
+        }
+    }
+}
+
+// Public Function: save
+// Input: path - The file to write the snapshot to.
+// Output: Returns true if the whole file was written.
+// The snapshot is written to a temporary file next to path that is then
+// renamed over it. Processes that still have the old file mapped keep
+// seeing the old keys, and none ever sees a partly written file. The
+// temporary file gets a unique name from mkstemp, so two processes or
+// threads saving to the same path never write into the same file; the one
+// that renames last wins. The snapshot is made readable by everyone, as
+// other processes are expected to map it.
+template <class Key, class Compare>
+bool FrozenBinarySearchTree<Key, Compare>::save(const char *path)
+{
+    static_assert(is_trivially_copyable<Key>::value,
+                  "Only keys that can be copied byte by byte can be saved");
+    static_assert(sizeof(SnapshotHeader) == 64,
+                  "The header must fill exactly one cache line");
+
+    SnapshotHeader header;
+    string temporaryPath = string(path) + ".XXXXXX";
+    const char *keys = NULL;
+    Key emptySlot = Key();
+
+    if (m_size > 0)
+    {
+        keys = reinterpret_cast<const char *>(m_keys + 1);
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "BSTSNAP", 8);
+    header.version = SNAPSHOT_VERSION;
+    header.keySize = sizeof(Key);
+    header.byteOrder = BYTE_ORDER_MARKER;
+    header.keyCount = m_size;
+    header.checksum = checksum(keys, m_size * sizeof(Key));
+
+    // mkstemp replaces the X's with a name no other file has:
+    int descriptor = mkstemp(&temporaryPath[0]);
+
+    if (descriptor < 0)
+    {
+        return false;
+    }
+
+    FILE *file = NULL;
+
+    if (fchmod(descriptor, 0644) != 0 ||
+        (file = fdopen(descriptor, "wb")) == NULL)
+    {
+        close(descriptor);
+        remove(temporaryPath.c_str());
+        return false;
+    }
+
+    // Slot 0 is unused, but writing it keeps the file identical to the
+    // array, so mapping the file needs no adjustment:
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(&emptySlot, sizeof(Key), 1, file) == 1 &&
+                   (m_size == 0 ||
+                    fwrite(keys, sizeof(Key), m_size, file) == m_size);
+
+    written = (fclose(file) == 0) && written;
+
+    if (!written || rename(temporaryPath.c_str(), path) != 0)
+    {
+        remove(temporaryPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Public Function: loadMapped
+// Input: path - A file written by save().
+//        verifyChecksum - Whether to check the keys against the checksum in
+//                         the header. This reads the whole file once; without
+//                         it, loading takes constant time and the keys are
+//                         read from disk only as searches reach them.
+// Output: Returns true if the file is a valid snapshot for this key type,
+//          in which case the snapshot now searches the mapped file. On
+//          failure the snapshot is left unchanged.
+// The file is mapped read-only and shared, so it stays in the page cache for
+// every process that maps it. It stays mapped until the snapshot is rebuilt,
+// loaded again or destroyed.
+template <class Key, class Compare>
+bool FrozenBinarySearchTree<Key, Compare>::loadMapped(const char *path,
+                                                      bool verifyChecksum)
+{
+    static_assert(is_trivially_copyable<Key>::value,
+                  "Only keys that can be copied byte by byte can be loaded");
+
+    int file = open(path, O_RDONLY);
+
+    if (file < 0)
+    {
+        return false;
+    }
+
+    struct stat status;
+
+    if (fstat(file, &status) != 0 ||
+        static_cast<size_t>(status.st_size) < sizeof(SnapshotHeader))
+    {
+        close(file);
+        return false;
+    }
+
+    size_t fileSize = status.st_size;
+    void *mapping = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, file, 0);
+
+    // The mapping keeps the file open by itself:
+    close(file);
+
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    const SnapshotHeader *header = static_cast<SnapshotHeader *>(mapping);
+    const char *keys = static_cast<char *>(mapping) + sizeof(SnapshotHeader);
+    bool valid = memcmp(header->magic, "BSTSNAP", 8) == 0 &&
+                 header->version == SNAPSHOT_VERSION &&
+                 header->keySize == sizeof(Key) &&
+                 header->byteOrder == BYTE_ORDER_MARKER &&
+                 header->keyCount < fileSize / sizeof(Key) &&
+                 fileSize == sizeof(SnapshotHeader) +
+                             (header->keyCount + 1) * sizeof(Key);
+
+    if (valid && verifyChecksum)
+    {
+        valid = checksum(keys + sizeof(Key),
+                         header->keyCount * sizeof(Key)) == header->checksum;
+    }
+
+    if (!valid)
+    {
+        munmap(mapping, fileSize);
+        return false;
+    }
+
+    // Drop the memory of any previous contents:
+    unmap();
+    vector<Key>().swap(m_storage);
+
+    m_mapping = mapping;
+    m_mappingSize = fileSize;
+    m_keys = reinterpret_cast<Key *>(const_cast<char *>(keys));
+    m_size = header->keyCount;
+
+    return true;
+}
+
+// Public Function: containsNode
+// Input: key - The key to search for in the snapshot.
+// Output: Returns true if the snapshot contains the key, otherwise false.
+template <class Key, class Compare>
+bool FrozenBinarySearchTree<Key, Compare>::containsNode(const Key &key)
+{
+    return findKey(key);
+}
+
+// Public Function: containsNode
+// Input: key - A value comparable with the keys of the snapshot.
+// Output: Returns true if the snapshot contains a key equivalent to the input,
+//          otherwise false.
+// Only available when Compare is transparent, e.g. less<>, so that a
+// string_view can be looked up among string keys without a temporary string.
+template <class Key, class Compare>
+template <class K, class C, class>
+bool FrozenBinarySearchTree<Key, Compare>::containsNode(const K &key)
+{
+    return findKey(key);
+}
+
+// Public Function: size
+// Input: None.
+// Output: The number of keys in the snapshot.
+template <class Key, class Compare>
+size_t FrozenBinarySearchTree<Key, Compare>::size()
+{
+    return m_size;
+}
+
+
+////
+//// Private functions:
+////
+
+// Private Function: findKey
+// Input: key - The value to search for in the snapshot.
+// Output: Returns true if the snapshot contains an equivalent key.
+// The prefetches near the bottom of the tree point past the end of the keys.
+// Their addresses are computed as integers, since a pointer that far past
+// the array would be undefined, and a prefetch never faults.
+// The loop always descends to the bottom of the implicit tree, going right
+// whenever the current key is smaller than the search key, so the only branch
+// is the loop condition. The position we end at encodes the path taken: each
+// right turn appended a 1 bit. Stripping the trailing 1s and one more bit
+// gives the last position where we turned left, which holds the smallest key
+// that is not less than the search key.
+template <class Key, class Compare>
+template <class K>
+bool FrozenBinarySearchTree<Key, Compare>::findKey(const K &key)
+{
+    const uintptr_t keys = reinterpret_cast<uintptr_t>(m_keys);
+    size_t position = 1;
+
+    while (position <= m_size)
+    {
+        __builtin_prefetch(reinterpret_cast<const void *>(
+            keys + KEYS_PER_CACHE_LINE * sizeof(Key) * position));
+        position = 2 * position + m_compare(m_keys[position], key);
+    }
+
+    position >>= __builtin_ffsll(~static_cast<unsigned long long>(position));
+
+    return position != 0 && !m_compare(key, m_keys[position]);
+}
+
+// Private Function: unmap
+// Input: None.
+// Output: None.
+// Releases the mapped file, if there is one, leaving the snapshot empty.
+template <class Key, class Compare>
+void FrozenBinarySearchTree<Key, Compare>::unmap()
+{
+    if (m_mapping != NULL)
+    {
+        munmap(m_mapping, m_mappingSize);
+        m_mapping = NULL;
+        m_mappingSize = 0;
+        m_keys = NULL;
+        m_size = 0;
+    }
+}
+
+// Private Function: checksum
+// Input: data - The bytes to check.
+//        length - The number of bytes.
+// Output: A 64-bit hash of the bytes.
+// FNV-1a applied to whole 64-bit words instead of single bytes, with a shift
+// mixing the high bits back down, so it runs at several bytes per cycle.
+template <class Key, class Compare>
+uint64_t FrozenBinarySearchTree<Key, Compare>::checksum(const char *data,
+                                                        size_t length)
+{
+    const uint64_t PRIME = 0x100000001b3ULL;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t i = 0;
+
+    for (; i + 8 <= length; i += 8)
+    {
+        uint64_t word;
+
+        memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * PRIME;
+        hash ^= hash >> 32;
+    }
+
+    for (; i < length; ++i)
+    {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * PRIME;
+    }
+
+    return hash;
+}
+
+#endif // FROZEN_BINARY_SEARCH_TREE_H
@@ -14,7 +14,7 @@
  * is 2, and the path is: root->(2)->(5)->leaf.
  *
  * The implementation of the minimum depth algorithm is in the
- * BinarySearchTree.cpp file.
+ * BinarySearchTree.h file.
  */
 
 #include <iostream>
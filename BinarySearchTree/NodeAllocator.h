@@ -0,0 +1,204 @@
+/*  File: NodeAllocator.h
+ *  This file contains the declaration and implementation of the NodeAllocator
+ *  class template.
+ *  A NodeAllocator hands out memory for nodes carved from large pages of
+ *  contiguous memory instead of calling new and delete for every node.
+ *  Nodes that are given back are kept on a free list and recycled by later
+ *  allocations, and all the pages can be released at once without visiting
+ *  the individual nodes, which makes destroying a whole tree O(pages).
+ *
+ *  The allocator only manages memory: the caller constructs each node in the
+ *  memory returned by allocate() with placement new, and must destroy it
+ *  before handing it back (or before releaseAll() if the node type has a
+ *  non-trivial destructor).
+ *
+ *  Every node is aligned as NodeType requires, even when that is stricter
+ *  than the alignment operator new guarantees, e.g. for keys declared with
+ *  alignas(64).
+ */
+
+#ifndef NODE_ALLOCATOR_H
+#define NODE_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+using namespace std;
+
+// Data Structure: NodeAllocator
+template <class NodeType>
+class NodeAllocator
+{
+    public:
+        static const size_t DEFAULT_NODES_PER_PAGE = 1024;
+
+        NodeAllocator(size_t nodesPerPage = DEFAULT_NODES_PER_PAGE);
+        ~NodeAllocator();
+
+        void *allocate();
+        void deallocate(void *node);
+        void releaseAll();
+        void reserve(size_t count);
+        size_t pageCount();
+
+    private:
+        // A free slot holds only the link to the next free slot. Tree nodes
+        // always have child pointers, so they are large enough to hold one:
+        struct FreeSlot
+        {
+            FreeSlot *next;
+        };
+
+        // Copying would release the same pages twice:
+        NodeAllocator(const NodeAllocator &);
+        NodeAllocator &operator=(const NodeAllocator &);
+
+        void addPage(size_t nodeCount);
+
+        // The bytes a page needs beyond its nodes so that the first can be
+        // moved up to an address aligned for NodeType. sizeof(NodeType) is a
+        // multiple of its alignment, so the nodes after it are aligned too:
+        static const size_t PAGE_PADDING =
+            alignof(NodeType) > alignof(max_align_t) ?
+            alignof(NodeType) - 1 : 0;
+
+        size_t m_nodesPerPage;
+        vector<void *> m_pages; // As returned by operator new.
+        FreeSlot *m_freeList; // Recycled nodes.
+        char *m_nextNode;     // Next never-used node in the newest page.
+        char *m_pageEnd;      // One past the last node in the newest page.
+};
+
+
+////
+//// Public Functions:
+////
+
+template <class NodeType>
+NodeAllocator<NodeType>::NodeAllocator(size_t nodesPerPage)
+{
+    m_nodesPerPage = (nodesPerPage > 0 ? nodesPerPage : 1);
+    m_freeList = NULL;
+    m_nextNode = NULL;
+    m_pageEnd = NULL;
+}
+
+template <class NodeType>
+NodeAllocator<NodeType>::~NodeAllocator()
+{
+    releaseAll();
+}
+
+// Public Function: allocate
+// Input: None.
+// Output: Returns a pointer to uninitialized memory for one node.
+// Recently freed nodes are reused first since they are likely still in the
+// cache. Otherwise the next unused node of the newest page is handed out, and
+// a new page is added only when that page is full.
+template <class NodeType>
+void *NodeAllocator<NodeType>::allocate()
+{
+    if (m_freeList != NULL)
+    {
+        FreeSlot *slot = m_freeList;
+        m_freeList = slot->next;
+        return slot;
+    }
+
+    if (m_nextNode == m_pageEnd)
+    {
+        addPage(m_nodesPerPage);
+    }
+
+    void *node = m_nextNode;
+    m_nextNode += sizeof(NodeType);
+    return node;
+}
+
+// Public Function: deallocate
+// Input: node - Memory previously returned by allocate(), whose node has
+//               already been destroyed.
+// Output: None.
+// The memory is pushed on the free list; it stays in its page until
+// releaseAll() is called.
+template <class NodeType>
+void NodeAllocator<NodeType>::deallocate(void *node)
+{
+    FreeSlot *slot = static_cast<FreeSlot *>(node);
+
+    slot->next = m_freeList;
+    m_freeList = slot;
+}
+
+// Public Function: releaseAll
+// Input: None.
+// Output: None.
+// Returns every page to the system. Any node previously handed out by this
+// allocator becomes invalid.
+template <class NodeType>
+void NodeAllocator<NodeType>::releaseAll()
+{
+    for (size_t i = 0; i < m_pages.size(); ++i)
+    {
+        ::operator delete(m_pages[i]);
+    }
+
+    m_pages.clear();
+    m_freeList = NULL;
+    m_nextNode = NULL;
+    m_pageEnd = NULL;
+}
+
+// Public Function: reserve
+// Input: count - The number of nodes about to be allocated.
+// Output: None.
+// Guarantees that the next count nodes handed out from fresh memory are
+// adjacent in a single page. If the newest page does not have room, a page
+// of at least count nodes is added and the rest of the old page is left
+// unused until releaseAll(). Nodes on the free list are still handed out
+// first, so this is most useful right after releaseAll().
+template <class NodeType>
+void NodeAllocator<NodeType>::reserve(size_t count)
+{
+    if (static_cast<size_t>(m_pageEnd - m_nextNode) < count * sizeof(NodeType))
+    {
+        addPage(count > m_nodesPerPage ? count : m_nodesPerPage);
+    }
+}
+
+// Public Function: pageCount
+// Input: None.
+// Output: The number of pages currently held by the allocator.
+template <class NodeType>
+size_t NodeAllocator<NodeType>::pageCount()
+{
+    return m_pages.size();
+}
+
+
+////
+//// Private functions:
+////
+
+// Private Function: addPage
+// Input: nodeCount - The number of nodes in the new page.
+// Output: None.
+// Allocates a new page and makes it the one that fresh nodes come from.
+template <class NodeType>
+void NodeAllocator<NodeType>::addPage(size_t nodeCount)
+{
+    void *memory = ::operator new(nodeCount * sizeof(NodeType) +
+                                  PAGE_PADDING);
+    uintptr_t address = reinterpret_cast<uintptr_t>(memory);
+    char *page = static_cast<char *>(memory) +
+                 (alignof(NodeType) - address % alignof(NodeType)) %
+                 alignof(NodeType);
+
+    m_pages.push_back(memory);
+    m_nextNode = page;
+    m_pageEnd = page + nodeCount * sizeof(NodeType);
+}
+
+#endif // NODE_ALLOCATOR_H
@@ -0,0 +1,851 @@
+/*  File: PersistentBinarySearchTree.h
+ *  This file contains the declaration and implementation of the
+ *  PersistentBinarySearchTreeNode structure and the
+ *  PersistentBinarySearchTree and VersionedBinarySearchTree class templates.
+ *
+ *  A PersistentBinarySearchTree is one version of an AVL tree of keys, and
+ *  never changes. insertNode and removeNode return a new version instead of
+ *  changing this one: they copy the O(log n) nodes on the path from the
+ *  root to the change, rebalance the copies, and share every other subtree
+ *  with the version they started from. Nodes are immutable and reference
+ *  counted (a count of the parents and versions that point at them), so
+ *  copying a version is O(1) and any number of versions, on any threads,
+ *  can be kept for as long as they are needed. A node is freed by whichever
+ *  thread drops the last reference to it, which is why nodes come from new
+ *  and delete rather than from a NodeAllocator, which is not thread-safe.
+ *
+ *  A VersionedBinarySearchTree holds the current version of a tree that
+ *  writers keep changing. snapshot() hands out the current version in O(1)
+ *  without blocking and without ever being blocked by a writer; the reader
+ *  can then search or walk it at leisure while the writers move on. Writers
+ *  are serialized by a mutex among themselves only.
+ *  The one delicate moment is between a reader loading the current root and
+ *  adding its reference: a writer must not drop the old version's reference
+ *  in between. This is handled with the same epochs as in
+ *  ConcurrentBinarySearchTree: readers announce the epoch before loading the
+ *  root, and a replaced version is only released once no reader announced
+ *  an epoch as old as its own.
+ *
+ *  Compile with -std=c++11 -pthread (or later).
+ */
+
+#ifndef PERSISTENT_BINARY_SEARCH_TREE_H
+#define PERSISTENT_BINARY_SEARCH_TREE_H
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <utility>
+
+using namespace std;
+
+// Data Structure: PersistentBinarySearchTreeNode
+// Everything but the reference count is fixed when the node is built.
+template <class Key>
+struct PersistentBinarySearchTreeNode
+{
+    PersistentBinarySearchTreeNode(const Key &newKey,
+                                   PersistentBinarySearchTreeNode *newLeft,
+                                   PersistentBinarySearchTreeNode *newRight,
+                                   int newHeight, size_t newSize)
+        : key(newKey), height(newHeight), size(newSize), left(newLeft),
+          right(newRight), references(1)
+    {
+    }
+
+    const Key key;
+    const int height;
+    const size_t size; // Number of nodes in the subtree rooted here.
+    PersistentBinarySearchTreeNode *const left;
+    PersistentBinarySearchTreeNode *const right;
+    atomic<size_t> references;
+};
+
+template <class Key, class Compare>
+class VersionedBinarySearchTree;
+
+// Data Structure: PersistentBinarySearchTree
+template <class Key, class Compare = less<Key> >
+class PersistentBinarySearchTree
+{
+    public:
+        PersistentBinarySearchTree(const Compare &compare = Compare());
+        PersistentBinarySearchTree(const PersistentBinarySearchTree &other);
+        PersistentBinarySearchTree(PersistentBinarySearchTree &&other);
+        PersistentBinarySearchTree &operator=(
+            PersistentBinarySearchTree other);
+        ~PersistentBinarySearchTree();
+
+        PersistentBinarySearchTree insertNode(const Key &key) const;
+        PersistentBinarySearchTree removeNode(const Key &key) const;
+        bool containsNode(const Key &key) const;
+        size_t size() const;
+        template <class Function>
+        void forEachInRange(const Key &low, const Key &high,
+                            Function callback) const;
+
+    private:
+        typedef PersistentBinarySearchTreeNode<Key> Node;
+
+        friend class VersionedBinarySearchTree<Key, Compare>;
+
+        // An AVL tree of n nodes is less than 1.45 log2(n + 2) tall, so this
+        // bounds the height of any tree that fits in a 64-bit address space:
+        static const int MAX_HEIGHT = 96;
+
+        PersistentBinarySearchTree(Node *root, const Compare &compare);
+
+        static bool findKey(const Key &key, Node *node,
+                            const Compare &compare);
+        Node *insertKey(const Key &key, Node *node) const;
+        Node *removeKey(const Key &key, Node *node) const;
+        Node *removeSmallest(Node *node, Node *&smallest) const;
+        static Node *makeNode(const Key &key, Node *left, Node *right);
+        static Node *balance(const Key &key, Node *left, Node *right);
+        static int height(Node *node);
+        static size_t size(Node *node);
+        static Node *share(Node *node);
+        static void release(Node *node);
+
+        Node *m_root; // This version holds one reference to it.
+        Compare m_compare;
+};
+
+// Data Structure: VersionedBinarySearchTree
+template <class Key, class Compare = less<Key> >
+class VersionedBinarySearchTree
+{
+    public:
+        static const size_t READER_SLOTS = 256;
+
+        VersionedBinarySearchTree(const Compare &compare = Compare());
+
+        void insertNode(const Key &key);
+        void removeNode(const Key &key);
+        bool containsNode(const Key &key);
+        PersistentBinarySearchTree<Key, Compare> snapshot();
+        size_t retiredVersionCount();
+
+    private:
+        typedef PersistentBinarySearchTreeNode<Key> Node;
+        typedef PersistentBinarySearchTree<Key, Compare> Version;
+
+        // A version that is no longer current, and the epoch at which that
+        // happened:
+        struct RetiredVersion
+        {
+            Version version;
+            uint64_t epoch;
+        };
+
+        // Each slot sits on its own cache line so that readers on different
+        // threads do not slow each other down. An epoch of zero marks a free
+        // slot.
+        struct ReaderSlot
+        {
+            alignas(64) atomic<uint64_t> epoch;
+        };
+
+        // Copying would copy the reader slots of a live tree:
+        VersionedBinarySearchTree(const VersionedBinarySearchTree &);
+        VersionedBinarySearchTree &operator=(
+            const VersionedBinarySearchTree &);
+
+        size_t enterRead();
+        void exitRead(size_t slot);
+        void publish(Version &version);
+        void reclaim();
+
+        atomic<Node *> m_root; // The root of m_current.
+        atomic<uint64_t> m_epoch;
+        ReaderSlot m_readers[READER_SLOTS];
+        const Compare m_compare; // Readers use this rather than m_current's.
+
+        // Everything below is only touched by writers holding m_writeLock:
+        mutex m_writeLock;
+        Version m_current;
+        deque<RetiredVersion> m_retired; // Oldest epoch first.
+};
+
+
+////
+//// Public Functions:
+////
+
+// Public Function: PersistentBinarySearchTree
+// Input: compare - The ordering of the keys.
+// Creates an empty version.
+template <class Key, class Compare>
+PersistentBinarySearchTree<Key, Compare>::PersistentBinarySearchTree(
+    const Compare &compare)
+    : m_compare(compare)
+{
+    m_root = NULL;
+}
+
+// Copying a version only adds a reference to its root:
+template <class Key, class Compare>
+PersistentBinarySearchTree<Key, Compare>::PersistentBinarySearchTree(
+    const PersistentBinarySearchTree &other)
+    : m_compare(other.m_compare)
+{
+    m_root = share(other.m_root);
+}
+
+template <class Key, class Compare>
+PersistentBinarySearchTree<Key, Compare>::PersistentBinarySearchTree(
+    PersistentBinarySearchTree &&other)
+    : m_compare(other.m_compare)
+{
+    m_root = other.m_root;
+    other.m_root = NULL;
+}
+
+template <class Key, class Compare>
+PersistentBinarySearchTree<Key, Compare> &
+PersistentBinarySearchTree<Key, Compare>::operator=(
+    PersistentBinarySearchTree other)
+{
+    swap(m_root, other.m_root);
+    swap(m_compare, other.m_compare);
+
+    return *this;
+}
+
+template <class Key, class Compare>
+PersistentBinarySearchTree<Key, Compare>::~PersistentBinarySearchTree()
+{
+    release(m_root);
+}
+
+// Public Function: insertNode
+// Input: key - Key to be added.
+// Output: Returns a version that also contains the key. This version is
+//          unchanged. If it already contained the key, the result shares its
+//          root and nothing is copied.
+template <class Key, class Compare>
+PersistentBinarySearchTree<Key, Compare>
+PersistentBinarySearchTree<Key, Compare>::insertNode(const Key &key) const
+{
+    Node *root = insertKey(key, m_root);
+
+    if (root == m_root)
+    {
+        return *this;
+    }
+
+    return PersistentBinarySearchTree(root, m_compare);
+}
+
+// Public Function: removeNode
+// Input: key - Key to be removed.
+// Output: Returns a version without the key. This version is unchanged. If
+//          it did not contain the key, the result shares its root and nothing
+//          is copied.
+template <class Key, class Compare>
+PersistentBinarySearchTree<Key, Compare>
+PersistentBinarySearchTree<Key, Compare>::removeNode(const Key &key) const
+{
+    Node *root = removeKey(key, m_root);
+
+    if (root == m_root)
+    {
+        return *this;
+    }
+
+    return PersistentBinarySearchTree(root, m_compare);
+}
+
+// Public Function: containsNode
+// Input: key - The key to search for.
+// Output: Returns true if this version contains the key, otherwise false.
+template <class Key, class Compare>
+bool PersistentBinarySearchTree<Key, Compare>::containsNode(
+    const Key &key) const
+{
+    return findKey(key, m_root, m_compare);
+}
+
+// Public Function: size
+// Input: None.
+// Output: The number of keys in this version.
+template <class Key, class Compare>
+size_t PersistentBinarySearchTree<Key, Compare>::size() const
+{
+    return size(m_root);
+}
+
+// Public Function: forEachInRange
+// Input: low, high - The smallest and largest keys wanted.
+//        callback - Called with each key from low to high inclusive, in
+//                   increasing order.
+// Output: None.
+// The nodes have no parent pointers, since they are shared between versions
+// with different parents, so the walk keeps its own stack of the nodes whose
+// keys and right subtrees are still to come.
+template <class Key, class Compare>
+template <class Function>
+void PersistentBinarySearchTree<Key, Compare>::forEachInRange(
+    const Key &low, const Key &high, Function callback) const
+{
+    Node *stack[MAX_HEIGHT];
+    int depth = 0;
+    Node *node = m_root;
+
+    for (;;)
+    {
+        // Go down to the smallest key not less than low, remembering the
+        // nodes passed on the way that are in the range:
+        while (node != NULL)
+        {
+            if (m_compare(node->key, low))
+            {
+                node = node->right;
+            }
+            else
+            {
+                stack[depth++] = node;
+                node = node->left;
+            }
+        }
+
+        if (depth == 0)
+        {
+            return;
+        }
+
+        node = stack[--depth];
+
+        if (m_compare(high, node->key))
+        {
+            return;
+        }
+
+        callback(node->key);
+        node = node->right;
+    }
+}
+
+// Public Function: VersionedBinarySearchTree
+// Input: compare - The ordering of the keys.
+template <class Key, class Compare>
+VersionedBinarySearchTree<Key, Compare>::VersionedBinarySearchTree(
+    const Compare &compare)
+    : m_root(NULL), m_epoch(1), m_compare(compare), m_current(compare)
+{
+    for (size_t i = 0; i < READER_SLOTS; ++i)
+    {
+        m_readers[i].epoch.store(0);
+    }
+}
+
+// Public Function: insertNode
+// Input: key - Key to be added to the tree.
+// Output: None.
+// Runs concurrently with any number of readers, but waits for other
+// insertions and removals. Snapshots taken earlier do not see the key.
+template <class Key, class Compare>
+void VersionedBinarySearchTree<Key, Compare>::insertNode(const Key &key)
+{
+    lock_guard<mutex> lock(m_writeLock);
+    Version version = m_current.insertNode(key);
+
+    if (version.m_root != m_current.m_root)
+    {
+        publish(version);
+    }
+}
+
+// Public Function: removeNode
+// Input: key - Key indicating which node to remove.
+// Output: None.
+// Runs concurrently with any number of readers, but waits for other
+// insertions and removals. Snapshots taken earlier still contain the key.
+template <class Key, class Compare>
+void VersionedBinarySearchTree<Key, Compare>::removeNode(const Key &key)
+{
+    lock_guard<mutex> lock(m_writeLock);
+    Version version = m_current.removeNode(key);
+
+    if (version.m_root != m_current.m_root)
+    {
+        publish(version);
+    }
+}
+
+// Public Function: containsNode
+// Input: key - The key to search for in the current version.
+// Output: Returns true if the tree contains the key, otherwise false.
+// Never blocks, and takes no reference: the epoch keeps the version alive
+// for the length of the search.
+template <class Key, class Compare>
+bool VersionedBinarySearchTree<Key, Compare>::containsNode(const Key &key)
+{
+    size_t slot = enterRead();
+    bool found = Version::findKey(key, m_root.load(), m_compare);
+
+    exitRead(slot);
+
+    return found;
+}
+
+// Public Function: snapshot
+// Input: None.
+// Output: Returns the current version. It stays valid and unchanged, on any
+//          thread, for as long as it or a copy of it is kept, whatever the
+//          writers do meanwhile.
+// O(1) and never blocks.
+template <class Key, class Compare>
+PersistentBinarySearchTree<Key, Compare>
+VersionedBinarySearchTree<Key, Compare>::snapshot()
+{
+    size_t slot = enterRead();
+    Node *root = Version::share(m_root.load());
+
+    exitRead(slot);
+
+    return Version(root, m_compare);
+}
+
+// Public Function: retiredVersionCount
+// Input: None.
+// Output: The number of replaced versions still waiting for readers to
+//          finish loading them before their references can be dropped.
+template <class Key, class Compare>
+size_t VersionedBinarySearchTree<Key, Compare>::retiredVersionCount()
+{
+    lock_guard<mutex> lock(m_writeLock);
+
+    return m_retired.size();
+}
+
+
+////
+//// Private functions:
+////
+
+// Private Function: PersistentBinarySearchTree
+// Input: root - The root of the version, whose reference the new version
+//               takes over.
+//        compare - The ordering of the keys.
+template <class Key, class Compare>
+PersistentBinarySearchTree<Key, Compare>::PersistentBinarySearchTree(
+    Node *root, const Compare &compare)
+    : m_compare(compare)
+{
+    m_root = root;
+}
+
+// Private Function: findKey
+// Input: key - The key to search for.
+//        node - The root of the subtree to search.
+//        compare - The ordering of the keys.
+// Output: Returns true if the subtree contains the key, otherwise false.
+template <class Key, class Compare>
+bool PersistentBinarySearchTree<Key, Compare>::findKey(const Key &key,
+                                                       Node *node,
+                                                       const Compare &compare)
+{
+    while (node != NULL)
+    {
+        bool goLeft = compare(key, node->key);
+        bool goRight = compare(node->key, key);
+
+        if (!goLeft && !goRight)
+        {
+            return true;
+        }
+
+        node = (goRight ? node->right : node->left);
+    }
+
+    return false;
+}
+
+// The functions below that build nodes follow one rule: a Node * passed to
+// makeNode or balance, or returned by any of them, is a reference handed
+// over to the receiver. Subtrees of the old version are passed on with
+// share(), which adds the reference they give away. The exception is a
+// function returning the very node it was given, which means nothing
+// changed below it and no reference is handed over.
+
+// Private Function: insertKey
+// Input: key - Key to be added to the subtree.
+//        node - The root of the subtree.
+// Output: Returns the root of a subtree that also contains the key, or node
+//          itself if the key was already present.
+template <class Key, class Compare>
+PersistentBinarySearchTreeNode<Key> *
+PersistentBinarySearchTree<Key, Compare>::insertKey(const Key &key,
+                                                    Node *node) const
+{
+    if (node == NULL)
+    {
+        return makeNode(key, NULL, NULL);
+    }
+
+    if (m_compare(key, node->key))
+    {
+        Node *left = insertKey(key, node->left);
+
+        if (left == node->left)
+        {
+            return node;
+        }
+
+        return balance(node->key, left, share(node->right));
+    }
+    else if (m_compare(node->key, key))
+    {
+        Node *right = insertKey(key, node->right);
+
+        if (right == node->right)
+        {
+            return node;
+        }
+
+        return balance(node->key, share(node->left), right);
+    }
+
+    return node;
+}
+
+// Private Function: removeKey
+// Input: key - Key to be removed from the subtree.
+//        node - The root of the subtree.
+// Output: Returns the root of a subtree without the key, or node itself if
+//          the key was not present.
+template <class Key, class Compare>
+PersistentBinarySearchTreeNode<Key> *
+PersistentBinarySearchTree<Key, Compare>::removeKey(const Key &key,
+                                                    Node *node) const
+{
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    if (m_compare(key, node->key))
+    {
+        Node *left = removeKey(key, node->left);
+
+        if (left == node->left)
+        {
+            return node;
+        }
+
+        return balance(node->key, left, share(node->right));
+    }
+    else if (m_compare(node->key, key))
+    {
+        Node *right = removeKey(key, node->right);
+
+        if (right == node->right)
+        {
+            return node;
+        }
+
+        return balance(node->key, share(node->left), right);
+    }
+
+    // This node contains the key. A missing child makes it easy:
+    if (node->left == NULL)
+    {
+        return share(node->right);
+    }
+    else if (node->right == NULL)
+    {
+        return share(node->left);
+    }
+
+    // Otherwise the successor's key takes the place of the removed key:
+    Node *successor;
+    Node *right = removeSmallest(node->right, successor);
+
+    return balance(successor->key, share(node->left), right);
+}
+
+// Private Function: removeSmallest
+// Input: node - The root of a non-empty subtree.
+//        smallest - Set to the node with the smallest key in the subtree,
+//                   which stays alive as part of the old version.
+// Output: Returns the root of the subtree without its smallest node.
+template <class Key, class Compare>
+PersistentBinarySearchTreeNode<Key> *
+PersistentBinarySearchTree<Key, Compare>::removeSmallest(
+    Node *node, Node *&smallest) const
+{
+    if (node->left == NULL)
+    {
+        smallest = node;
+        return share(node->right);
+    }
+
+    Node *left = removeSmallest(node->left, smallest);
+
+    return balance(node->key, left, share(node->right));
+}
+
+// Private Function: makeNode
+// Input: key - The key of the new node.
+//        left, right - The children of the new node.
+// Output: Returns a new node whose height and size are computed from its
+//          children.
+template <class Key, class Compare>
+PersistentBinarySearchTreeNode<Key> *
+PersistentBinarySearchTree<Key, Compare>::makeNode(const Key &key,
+                                                   Node *left, Node *right)
+{
+    int leftHeight = height(left);
+    int rightHeight = height(right);
+    int newHeight = 1 + (leftHeight > rightHeight ? leftHeight : rightHeight);
+
+    return new Node(key, left, right, newHeight,
+                    size(left) + size(right) + 1);
+}
+
+// Private Function: balance
+// Input: key - The key of the node to build.
+//        left, right - Balanced subtrees whose heights differ by at most two.
+// Output: Returns the root of a balanced subtree holding left, key and right.
+// As in ConcurrentBinarySearchTree, a rotation builds new nodes for the nodes
+// it would move. The subtree it takes apart is then released, which frees
+// it if it was only built during this update.
+template <class Key, class Compare>
+PersistentBinarySearchTreeNode<Key> *
+PersistentBinarySearchTree<Key, Compare>::balance(const Key &key, Node *left,
+                                                  Node *right)
+{
+    int leftHeight = height(left);
+    int rightHeight = height(right);
+    Node *result;
+
+    // Left subtree is too tall:
+    if (leftHeight > rightHeight + 1)
+    {
+        // Left-left case, a single right rotation:
+        if (height(left->left) >= height(left->right))
+        {
+            result = makeNode(left->key, share(left->left),
+                              makeNode(key, share(left->right), right));
+        }
+        // Left-right case, a double rotation:
+        else
+        {
+            Node *pivot = left->right;
+
+            result = makeNode(pivot->key,
+                              makeNode(left->key, share(left->left),
+                                       share(pivot->left)),
+                              makeNode(key, share(pivot->right), right));
+        }
+
+        release(left);
+        return result;
+    }
+    // Right subtree is too tall:
+    else if (rightHeight > leftHeight + 1)
+    {
+        // Right-right case, a single left rotation:
+        if (height(right->right) >= height(right->left))
+        {
+            result = makeNode(right->key,
+                              makeNode(key, left, share(right->left)),
+                              share(right->right));
+        }
+        // Right-left case, a double rotation:
+        else
+        {
+            Node *pivot = right->left;
+
+            result = makeNode(pivot->key,
+                              makeNode(key, left, share(pivot->left)),
+                              makeNode(right->key, share(pivot->right),
+                                       share(right->right)));
+        }
+
+        release(right);
+        return result;
+    }
+
+    return makeNode(key, left, right);
+}
+
+// Private Function: height
+// Input: node - The root of a subtree.
+// Output: The height of the subtree, or zero if it is empty.
+template <class Key, class Compare>
+int PersistentBinarySearchTree<Key, Compare>::height(Node *node)
+{
+    if (node != NULL)
+    {
+        return node->height;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+// Private Function: size
+// Input: node - The root of a subtree.
+// Output: The number of nodes in the subtree, or zero if it is empty.
+template <class Key, class Compare>
+size_t PersistentBinarySearchTree<Key, Compare>::size(Node *node)
+{
+    if (node != NULL)
+    {
+        return node->size;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+// Private Function: share
+// Input: node - A node, or NULL.
+// Output: Returns node, with one more reference to it.
+// The caller already holds a reference, directly or through a version, or
+// is inside an epoch that keeps one alive, so the count cannot reach zero
+// meanwhile and no ordering is needed.
+template <class Key, class Compare>
+PersistentBinarySearchTreeNode<Key> *
+PersistentBinarySearchTree<Key, Compare>::share(Node *node)
+{
+    if (node != NULL)
+    {
+        node->references.fetch_add(1, memory_order_relaxed);
+    }
+
+    return node;
+}
+
+// Private Function: release
+// Input: node - A node, or NULL.
+// Output: None.
+// Drops one reference. A node whose last reference is dropped is freed and
+// drops its references to its children in turn. The nodes freed form the
+// top of a subtree, and the stack holds at most one pending sibling per
+// level of it.
+template <class Key, class Compare>
+void PersistentBinarySearchTree<Key, Compare>::release(Node *node)
+{
+    Node *stack[MAX_HEIGHT + 1];
+    int depth = 0;
+
+    if (node != NULL)
+    {
+        stack[depth++] = node;
+    }
+
+    while (depth > 0)
+    {
+        node = stack[--depth];
+
+        // Acquiring makes every use of the node by other threads, which
+        // came before their releases, finish before it is freed:
+        if (node->references.fetch_sub(1, memory_order_acq_rel) != 1)
+        {
+            continue;
+        }
+
+        if (node->left != NULL)
+        {
+            stack[depth++] = node->left;
+        }
+
+        if (node->right != NULL)
+        {
+            stack[depth++] = node->right;
+        }
+
+        delete node;
+    }
+}
+
+// Private Function: enterRead
+// Input: None.
+// Output: Returns the index of the reader slot claimed by this reader.
+// As in ConcurrentBinarySearchTree, each thread starts at its own slot and
+// claims it with a compare-and-swap.
+template <class Key, class Compare>
+size_t VersionedBinarySearchTree<Key, Compare>::enterRead()
+{
+    static thread_local size_t preferredSlot =
+        hash<thread::id>()(this_thread::get_id()) % READER_SLOTS;
+    size_t slot = preferredSlot;
+    uint64_t epoch = m_epoch.load();
+
+    for (;;)
+    {
+        uint64_t freeEpoch = 0;
+
+        if (m_readers[slot].epoch.compare_exchange_strong(freeEpoch, epoch))
+        {
+            return slot;
+        }
+
+        slot = (slot + 1) % READER_SLOTS;
+    }
+}
+
+// Private Function: exitRead
+// Input: slot - The slot returned by enterRead.
+// Output: None.
+template <class Key, class Compare>
+void VersionedBinarySearchTree<Key, Compare>::exitRead(size_t slot)
+{
+    m_readers[slot].epoch.store(0, memory_order_release);
+}
+
+// Private Function: publish
+// Input: version - The version produced by the current write. It is moved
+//                  from.
+// Output: None.
+// Makes the new version current, retires the old one with the current
+// epoch, advances the epoch and releases whatever is now safe.
+template <class Key, class Compare>
+void VersionedBinarySearchTree<Key, Compare>::publish(Version &version)
+{
+    m_root.store(version.m_root);
+
+    RetiredVersion retired = { move(m_current), m_epoch.fetch_add(1) };
+
+    m_retired.push_back(move(retired));
+    m_current = move(version);
+    reclaim();
+}
+
+// Private Function: reclaim
+// Input: None.
+// Output: None.
+// Releases the retired versions whose epoch is older than that of every
+// reader in progress. A reader that has not yet announced itself will load
+// the current root, which is not retired.
+template <class Key, class Compare>
+void VersionedBinarySearchTree<Key, Compare>::reclaim()
+{
+    uint64_t oldestEpoch = m_epoch.load();
+
+    for (size_t i = 0; i < READER_SLOTS; ++i)
+    {
+        uint64_t epoch = m_readers[i].epoch.load();
+
+        if (epoch != 0 && epoch < oldestEpoch)
+        {
+            oldestEpoch = epoch;
+        }
+    }
+
+    while (!m_retired.empty() && m_retired.front().epoch < oldestEpoch)
+    {
+        m_retired.pop_front();
+    }
+}
+
+#endif // PERSISTENT_BINARY_SEARCH_TREE_H
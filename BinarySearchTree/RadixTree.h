@@ -0,0 +1,678 @@
+/*  File: RadixTree.h
+ *  This file contains the declaration and implementation of the RadixTree
+ *  class, an ordered set of int keys with the same interface as
+ *  BinarySearchTree: insertNode, removeNode, containsNode, successor,
+ *  predecessor, size and a destroy function.
+ *  Instead of comparing keys, a RadixTree uses the bits of each key as the
+ *  path to it. The 32 bits are split into six digits: one of 2 bits and
+ *  five of 6 bits, most significant first. The first five digits each pick
+ *  one of up to 64 children at one level of the tree, and the last picks a
+ *  bit of a 64-bit word at the bottom, so every key sits exactly six steps
+ *  below the root whatever the number of keys, where a BinarySearchTree of
+ *  n keys is about log2(n) steps tall (22 for four million keys).
+ *
+ *  Each node stores a 64-bit map of which children are present, followed
+ *  only by the present children, in increasing order. The position of a
+ *  child is the number of map bits set below its own, found with a single
+ *  popcount, so a node with a few children takes a few words rather than
+ *  64. Nodes on the last level hold 64-bit words of key bits instead of
+ *  children. Dense keys, such as consecutive IDs, therefore take a little
+ *  over one bit each, and even widely scattered keys take less memory than
+ *  a node of a BinarySearchTree.
+ *  The maps also make ordered queries cheap: the next key after a given one
+ *  is found by masking a map to the children above the current one and
+ *  taking the lowest bit left, then following the first child of each node
+ *  down to the bottom.
+ *
+ *  A node grows by doubling when a child is added to a full one, and
+ *  shrinks by half when it falls to a quarter full, so a node's size stays
+ *  within four times what its children need.
+ */
+
+#ifndef RADIX_TREE_H
+#define RADIX_TREE_H
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdint.h>
+
+using namespace std;
+
+// Data Structure: RadixTreeSlot
+// A child of a node: another node, or on the last level a word of key bits.
+union RadixTreeSlot
+{
+    struct RadixTreeNode *child;
+    uint64_t bits;
+};
+
+// Data Structure: RadixTreeNode
+// The header of a node. Its slots follow it in the same block of memory.
+struct RadixTreeNode
+{
+    uint64_t present;  // Bit i is set if child i holds any keys.
+    uint64_t capacity; // The number of slots the block has room for.
+};
+
+// Data Structure: RadixTree
+class RadixTree
+{
+    public:
+        RadixTree();
+        ~RadixTree();
+
+        void insertNode(int key);
+        void removeNode(int key);
+        bool containsNode(int key);
+        bool successor(int key, int &next);
+        bool predecessor(int key, int &previous);
+        size_t size();
+        void destroyRadixTree();
+
+    private:
+        typedef RadixTreeNode Node;
+        typedef RadixTreeSlot Slot;
+
+        // The number of levels of nodes. The last digit of a key indexes
+        // a bit of a word rather than a child.
+        static const int LEVELS = 5;
+        static const int DIGIT_BITS = 6;
+
+        // Copying would share, and later free twice, the same nodes:
+        RadixTree(const RadixTree &);
+        RadixTree &operator=(const RadixTree &);
+
+        static uint32_t toBits(int key);
+        static int toKey(uint32_t bits);
+        static int shift(int level);
+        static int digit(uint32_t bits, int level);
+        static Slot *slots(Node *node);
+        static int slotIndex(Node *node, int digit);
+        static Node *allocateNode(uint64_t capacity);
+        static void freeNode(Node *node);
+        static Node *resizeNode(Node *node, uint64_t capacity);
+        static Node *addSlot(Node *node, int digit, int index);
+        static Node *removeSlot(Node *node, int digit, int index);
+        static void destroyNodes(Node *node, int level);
+        bool findAtLeast(uint32_t bits, uint32_t &found);
+        bool findAtMost(uint32_t bits, uint32_t &found);
+
+        Node *m_root;  // NULL while the tree is empty.
+        size_t m_size;
+};
+
+
+////
+//// Public Functions:
+////
+
+inline RadixTree::RadixTree()
+{
+    m_root = NULL;
+    m_size = 0;
+}
+
+inline RadixTree::~RadixTree()
+{
+    destroyRadixTree();
+}
+
+// Public Function: insertNode
+// Input: key - Key to be added to the tree.
+// Output: None.
+// Missing nodes on the key's path are created on the way down: a new slot
+// for a child starts out NULL and the next step fills it.
+inline void RadixTree::insertNode(int key)
+{
+    uint32_t bits = toBits(key);
+    Node **link = &m_root;
+
+    for (int level = 0; level < LEVELS; ++level)
+    {
+        if (*link == NULL)
+        {
+            *link = allocateNode(1);
+        }
+
+        int keyDigit = digit(bits, level);
+        int index = slotIndex(*link, keyDigit);
+
+        if (!((*link)->present >> keyDigit & 1))
+        {
+            *link = addSlot(*link, keyDigit, index);
+
+            if (level < LEVELS - 1)
+            {
+                slots(*link)[index].child = NULL;
+            }
+            else
+            {
+                slots(*link)[index].bits = 0;
+            }
+        }
+
+        if (level < LEVELS - 1)
+        {
+            link = &slots(*link)[index].child;
+        }
+        else
+        {
+            uint64_t &word = slots(*link)[index].bits;
+            uint64_t keyBit = uint64_t(1) << (bits & 63);
+
+            if (!(word & keyBit))
+            {
+                word |= keyBit;
+                ++m_size;
+            }
+        }
+    }
+}
+
+// Public Function: removeNode
+// Input: key - Key indicating which node to remove.
+// Output: None.
+// A word left with no keys is removed from its node, and a node left with
+// no children is freed and removed from its parent in turn.
+inline void RadixTree::removeNode(int key)
+{
+    uint32_t bits = toBits(key);
+    Node **links[LEVELS];
+    int indexes[LEVELS];
+    Node **link = &m_root;
+
+    for (int level = 0; level < LEVELS; ++level)
+    {
+        int keyDigit = digit(bits, level);
+
+        if (*link == NULL || !((*link)->present >> keyDigit & 1))
+        {
+            return;
+        }
+
+        links[level] = link;
+        indexes[level] = slotIndex(*link, keyDigit);
+        link = &slots(*link)[indexes[level]].child;
+    }
+
+    uint64_t &word = slots(*links[LEVELS - 1])[indexes[LEVELS - 1]].bits;
+    uint64_t keyBit = uint64_t(1) << (bits & 63);
+
+    if (!(word & keyBit))
+    {
+        return;
+    }
+
+    word &= ~keyBit;
+    --m_size;
+
+    if (word != 0)
+    {
+        return;
+    }
+
+    for (int level = LEVELS - 1; level >= 0; --level)
+    {
+        Node *node = removeSlot(*links[level], digit(bits, level),
+                                indexes[level]);
+
+        if (node->present != 0)
+        {
+            *links[level] = node;
+            return;
+        }
+
+        freeNode(node);
+        *links[level] = NULL;
+    }
+}
+
+// Public Function: containsNode
+// Input: key - The key to search for in the tree.
+// Output: Returns true if the tree contains the key, otherwise returns
+//          false.
+// Every child whose bit is set holds at least one key, so only the root can
+// be missing.
+inline bool RadixTree::containsNode(int key)
+{
+    uint32_t bits = toBits(key);
+    Node *node = m_root;
+
+    if (node == NULL)
+    {
+        return false;
+    }
+
+    for (int level = 0; level < LEVELS - 1; ++level)
+    {
+        int keyDigit = digit(bits, level);
+
+        if (!(node->present >> keyDigit & 1))
+        {
+            return false;
+        }
+
+        node = slots(node)[slotIndex(node, keyDigit)].child;
+    }
+
+    int keyDigit = digit(bits, LEVELS - 1);
+
+    if (!(node->present >> keyDigit & 1))
+    {
+        return false;
+    }
+
+    return slots(node)[slotIndex(node, keyDigit)].bits >> (bits & 63) & 1;
+}
+
+// Public Function: successor
+// Input: key - Any key, in the tree or not.
+//        next - Set to the smallest key in the tree that is greater than
+//               key, if there is one.
+// Output: Returns true if there is such a key, otherwise returns false and
+//          leaves next unchanged.
+inline bool RadixTree::successor(int key, int &next)
+{
+    uint32_t bits = toBits(key);
+    uint32_t found;
+
+    if (bits == UINT32_MAX || !findAtLeast(bits + 1, found))
+    {
+        return false;
+    }
+
+    next = toKey(found);
+    return true;
+}
+
+// Public Function: predecessor
+// Input: key - Any key, in the tree or not.
+//        previous - Set to the largest key in the tree that is less than
+//                   key, if there is one.
+// Output: Returns true if there is such a key, otherwise returns false and
+//          leaves previous unchanged.
+inline bool RadixTree::predecessor(int key, int &previous)
+{
+    uint32_t bits = toBits(key);
+    uint32_t found;
+
+    if (bits == 0 || !findAtMost(bits - 1, found))
+    {
+        return false;
+    }
+
+    previous = toKey(found);
+    return true;
+}
+
+// Public Function: size
+// Input: None.
+// Output: The number of keys in the tree.
+inline size_t RadixTree::size()
+{
+    return m_size;
+}
+
+// Public Function: destroyRadixTree
+// Input: None.
+// Output: None.
+// Removes every key and frees every node.
+inline void RadixTree::destroyRadixTree()
+{
+    destroyNodes(m_root, 0);
+    m_root = NULL;
+    m_size = 0;
+}
+
+
+////
+//// Private functions:
+////
+
+// Private Function: toBits
+// Input: key - A key.
+// Output: The key with its sign bit flipped, so that comparing the results
+//          as unsigned numbers gives the same order as comparing the keys.
+inline uint32_t RadixTree::toBits(int key)
+{
+    return static_cast<uint32_t>(key) ^ 0x80000000u;
+}
+
+// Private Function: toKey
+// Input: bits - The result of toBits for some key.
+// Output: That key.
+inline int RadixTree::toKey(uint32_t bits)
+{
+    return static_cast<int>(bits ^ 0x80000000u);
+}
+
+// Private Function: shift
+// Input: level - A level of nodes, 0 for the root.
+// Output: The position of the lowest bit of the digit used at that level.
+inline int RadixTree::shift(int level)
+{
+    return DIGIT_BITS * (LEVELS - level);
+}
+
+// Private Function: digit
+// Input: bits - A key, as returned by toBits.
+//        level - A level of nodes.
+// Output: The child of a node at that level that the key belongs to. At the
+//          root only the top two bits remain, so the digit is below 4.
+inline int RadixTree::digit(uint32_t bits, int level)
+{
+    return bits >> shift(level) & 63;
+}
+
+// Private Function: slots
+// Input: node - A node.
+// Output: The first of the slots stored after the node's header.
+inline RadixTreeSlot *RadixTree::slots(Node *node)
+{
+    return reinterpret_cast<Slot *>(node + 1);
+}
+
+// Private Function: slotIndex
+// Input: node - A node.
+//        digit - A child of the node, present or not.
+// Output: The position of that child among the slots: the number of present
+//          children before it.
+inline int RadixTree::slotIndex(Node *node, int digit)
+{
+    uint64_t below = (uint64_t(1) << digit) - 1;
+
+    return __builtin_popcountll(node->present & below);
+}
+
+// Private Function: allocateNode
+// Input: capacity - The number of slots to make room for.
+// Output: Returns a node with no children.
+inline RadixTreeNode *RadixTree::allocateNode(uint64_t capacity)
+{
+    Node *node = static_cast<Node *>(::operator new(sizeof(Node) +
+                                                    capacity * sizeof(Slot)));
+
+    node->present = 0;
+    node->capacity = capacity;
+
+    return node;
+}
+
+// Private Function: freeNode
+// Input: node - A node from allocateNode.
+// Output: None.
+inline void RadixTree::freeNode(Node *node)
+{
+    ::operator delete(node);
+}
+
+// Private Function: resizeNode
+// Input: node - A node.
+//        capacity - Its new number of slots, at least the number in use.
+// Output: Returns a copy of the node with the new capacity. The old node
+//          is freed.
+inline RadixTreeNode *RadixTree::resizeNode(Node *node, uint64_t capacity)
+{
+    Node *resized = allocateNode(capacity);
+
+    resized->present = node->present;
+    memcpy(slots(resized), slots(node),
+           __builtin_popcountll(node->present) * sizeof(Slot));
+    freeNode(node);
+
+    return resized;
+}
+
+// Private Function: addSlot
+// Input: node - A node.
+//        digit - A child the node does not have yet.
+//        index - Its slotIndex.
+// Output: Returns the node, or its replacement if it had to grow, with an
+//          uninitialized slot for the child.
+inline RadixTreeNode *RadixTree::addSlot(Node *node, int digit, int index)
+{
+    int count = __builtin_popcountll(node->present);
+
+    if (static_cast<uint64_t>(count) == node->capacity)
+    {
+        node = resizeNode(node, 2 * node->capacity);
+    }
+
+    Slot *nodeSlots = slots(node);
+
+    memmove(nodeSlots + index + 1, nodeSlots + index,
+            (count - index) * sizeof(Slot));
+    node->present |= uint64_t(1) << digit;
+
+    return node;
+}
+
+// Private Function: removeSlot
+// Input: node - A node.
+//        digit - A child of the node, which must have no keys left.
+//        index - Its slotIndex.
+// Output: Returns the node without the child, or its replacement if it
+//          shrank.
+inline RadixTreeNode *RadixTree::removeSlot(Node *node, int digit, int index)
+{
+    int count = __builtin_popcountll(node->present) - 1;
+    Slot *nodeSlots = slots(node);
+
+    memmove(nodeSlots + index, nodeSlots + index + 1,
+            (count - index) * sizeof(Slot));
+    node->present &= ~(uint64_t(1) << digit);
+
+    if (count > 0 && static_cast<uint64_t>(4 * count) <= node->capacity)
+    {
+        node = resizeNode(node, node->capacity / 2);
+    }
+
+    return node;
+}
+
+// Private Function: destroyNodes
+// Input: node - A node, or NULL.
+//        level - The level it is on.
+// Output: None.
+// Frees the node and everything below it. The tree is only LEVELS deep, so
+// the recursion is too.
+inline void RadixTree::destroyNodes(Node *node, int level)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+
+    if (level < LEVELS - 1)
+    {
+        int count = __builtin_popcountll(node->present);
+
+        for (int i = 0; i < count; ++i)
+        {
+            destroyNodes(slots(node)[i].child, level + 1);
+        }
+    }
+
+    freeNode(node);
+}
+
+// Private Function: findAtLeast
+// Input: bits - A key, as returned by toBits.
+//        found - Set to the smallest key in the tree that is not less than
+//                bits, if there is one.
+// Output: Returns true if there is such a key.
+// We follow the path of bits as far as it exists. Then, from the deepest
+// node reached upwards, we look for a present child after the one on the
+// path; the first one found leads, through the first child of every node
+// below it, to the answer.
+inline bool RadixTree::findAtLeast(uint32_t bits, uint32_t &found)
+{
+    Node *path[LEVELS];
+    Node *node = m_root;
+    int level = 0;
+
+    if (node == NULL)
+    {
+        return false;
+    }
+
+    for (; level < LEVELS; ++level)
+    {
+        int keyDigit = digit(bits, level);
+
+        path[level] = node;
+
+        if (!(node->present >> keyDigit & 1))
+        {
+            break;
+        }
+
+        Slot &slot = slots(node)[slotIndex(node, keyDigit)];
+
+        if (level < LEVELS - 1)
+        {
+            node = slot.child;
+            continue;
+        }
+
+        // Shifting the word left clears the bits of the smaller keys:
+        uint64_t later = slot.bits & (~uint64_t(0) << (bits & 63));
+
+        if (later != 0)
+        {
+            found = (bits & ~uint32_t(63)) | __builtin_ctzll(later);
+            return true;
+        }
+
+        break;
+    }
+
+    for (; level >= 0; --level)
+    {
+        node = path[level];
+
+        // Shifting twice leaves the mask empty when the digit is 63:
+        uint64_t after = (uint64_t(1) << digit(bits, level) << 1) - 1;
+        uint64_t later = node->present & ~after;
+
+        if (later == 0)
+        {
+            continue;
+        }
+
+        int laterDigit = __builtin_ctzll(later);
+        uint64_t prefix = uint64_t(bits) >> shift(level) >> DIGIT_BITS;
+
+        found = static_cast<uint32_t>(((prefix << DIGIT_BITS) | laterDigit)
+                                      << shift(level));
+
+        // The chosen child is slot slotIndex(laterDigit); below it the
+        // smallest child is always the first slot:
+        Slot slot = slots(node)[slotIndex(node, laterDigit)];
+
+        for (++level; level < LEVELS; ++level)
+        {
+            node = slot.child;
+            int firstDigit = __builtin_ctzll(node->present);
+
+            found |= static_cast<uint32_t>(firstDigit) << shift(level);
+            slot = slots(node)[0];
+        }
+
+        found |= __builtin_ctzll(slot.bits);
+        return true;
+    }
+
+    return false;
+}
+
+// Private Function: findAtMost
+// Input: bits - A key, as returned by toBits.
+//        found - Set to the largest key in the tree that is not greater
+//                than bits, if there is one.
+// Output: Returns true if there is such a key.
+// The mirror image of findAtLeast: we look for a present child before the
+// one on the path and then follow the last child of every node below it.
+inline bool RadixTree::findAtMost(uint32_t bits, uint32_t &found)
+{
+    Node *path[LEVELS];
+    Node *node = m_root;
+    int level = 0;
+
+    if (node == NULL)
+    {
+        return false;
+    }
+
+    for (; level < LEVELS; ++level)
+    {
+        int keyDigit = digit(bits, level);
+
+        path[level] = node;
+
+        if (!(node->present >> keyDigit & 1))
+        {
+            break;
+        }
+
+        Slot &slot = slots(node)[slotIndex(node, keyDigit)];
+
+        if (level < LEVELS - 1)
+        {
+            node = slot.child;
+            continue;
+        }
+
+        // Keeps the bits of this key and the smaller ones:
+        uint64_t upTo = (uint64_t(1) << (bits & 63) << 1) - 1;
+        uint64_t earlier = slot.bits & upTo;
+
+        if (earlier != 0)
+        {
+            found = (bits & ~uint32_t(63)) | (63 - __builtin_clzll(earlier));
+            return true;
+        }
+
+        break;
+    }
+
+    for (; level >= 0; --level)
+    {
+        node = path[level];
+
+        uint64_t before = (uint64_t(1) << digit(bits, level)) - 1;
+        uint64_t earlier = node->present & before;
+
+        if (earlier == 0)
+        {
+            continue;
+        }
+
+        int earlierDigit = 63 - __builtin_clzll(earlier);
+        uint64_t prefix = uint64_t(bits) >> shift(level) >> DIGIT_BITS;
+
+        found = static_cast<uint32_t>(((prefix << DIGIT_BITS) | earlierDigit)
+                                      << shift(level));
+
+        // Below the chosen child the largest child is always the last slot:
+        Slot slot = slots(node)[slotIndex(node, earlierDigit)];
+
+        for (++level; level < LEVELS; ++level)
+        {
+            node = slot.child;
+
+            int lastDigit = 63 - __builtin_clzll(node->present);
+
+            found |= static_cast<uint32_t>(lastDigit) << shift(level);
+            slot = slots(node)[__builtin_popcountll(node->present) - 1];
+        }
+
+        found |= 63 - __builtin_clzll(slot.bits);
+        return true;
+    }
+
+    return false;
+}
+
+#endif // RADIX_TREE_H
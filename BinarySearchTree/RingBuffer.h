@@ -0,0 +1,143 @@
+/*  File: RingBuffer.h
+ *  This file contains the declaration and implementation of the RingBuffer
+ *  class template.
+ *  A RingBuffer is a first-in first-out queue stored in one array whose
+ *  capacity is a power of two. Items are added at the tail and removed at the
+ *  head, and both wrap around the end of the array, so a queue that keeps
+ *  roughly the same number of items never moves or allocates anything. The
+ *  array only grows (doubling) when it is full, and clearing the queue keeps
+ *  it, so a RingBuffer that is reused allocates nothing once it has grown to
+ *  the largest size it needs.
+ *
+ *  Items must be default constructible and copyable.
+ */
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Data Structure: RingBuffer
+template <class T>
+class RingBuffer
+{
+    public:
+        RingBuffer();
+
+        void pushBack(const T &item);
+        T popFront();
+        bool empty();
+        size_t size();
+        void clear();
+
+    private:
+        static const size_t INITIAL_CAPACITY = 64;
+
+        void grow();
+
+        vector<T> m_items; // Empty until the first item is added.
+        size_t m_head;     // Index of the oldest item.
+        size_t m_count;
+};
+
+
+////
+//// Public Functions:
+////
+
+template <class T>
+RingBuffer<T>::RingBuffer()
+{
+    m_head = 0;
+    m_count = 0;
+}
+
+// Public Function: pushBack
+// Input: item - The item to add at the tail of the queue.
+// Output: None.
+template <class T>
+void RingBuffer<T>::pushBack(const T &item)
+{
+    if (m_count == m_items.size())
+    {
+        grow();
+    }
+
+    // The capacity is a power of two, so masking wraps the index around:
+    m_items[(m_head + m_count) & (m_items.size() - 1)] = item;
+    ++m_count;
+}
+
+// Public Function: popFront
+// Input: None.
+// Output: Removes and returns the item at the head of the queue, which must
+//          not be empty.
+template <class T>
+T RingBuffer<T>::popFront()
+{
+    T item = m_items[m_head];
+
+    m_head = (m_head + 1) & (m_items.size() - 1);
+    --m_count;
+
+    return item;
+}
+
+// Public Function: empty
+// Input: None.
+// Output: Returns true if the queue holds no items.
+template <class T>
+bool RingBuffer<T>::empty()
+{
+    return m_count == 0;
+}
+
+// Public Function: size
+// Input: None.
+// Output: The number of items in the queue.
+template <class T>
+size_t RingBuffer<T>::size()
+{
+    return m_count;
+}
+
+// Public Function: clear
+// Input: None.
+// Output: None.
+// Empties the queue but keeps its memory for reuse.
+template <class T>
+void RingBuffer<T>::clear()
+{
+    m_head = 0;
+    m_count = 0;
+}
+
+
+////
+//// Private functions:
+////
+
+// Private Function: grow
+// Input: None.
+// Output: None.
+// Doubles the capacity. The items are copied to the front of the new array in
+// queue order, so the head starts at zero again.
+template <class T>
+void RingBuffer<T>::grow()
+{
+    size_t capacity = m_items.size();
+    vector<T> items(capacity > 0 ? 2 * capacity : INITIAL_CAPACITY);
+
+    for (size_t i = 0; i < m_count; ++i)
+    {
+        items[i] = m_items[(m_head + i) & (capacity - 1)];
+    }
+
+    m_items.swap(items);
+    m_head = 0;
+}
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,276 @@
+/*  File: TreeDumper.h
+ *  This file contains the TraversalOrder enumeration and the declaration and
+ *  implementation of the TreeDumper class.
+ *  A TreeDumper writes the keys of a tree to a file, as text or as raw
+ *  binary, in any of the orders the tree's visit() function supports. The
+ *  keys are formatted straight into a buffer owned by the dumper, and the
+ *  buffer is handed to the file in one fwrite only when it is full. Integer
+ *  keys are formatted by hand rather than through iostreams, so a dump costs
+ *  a few nanoseconds per key plus the cost of moving the bytes. The buffer
+ *  is kept between dumps, so reusing a dumper allocates nothing.
+ */
+
+#ifndef TREE_DUMPER_H
+#define TREE_DUMPER_H
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+// Data Structure: TraversalOrder
+// The orders in which the nodes of a tree can be visited.
+enum TraversalOrder
+{
+    BREADTH_FIRST, // Level by level from the root, left to right.
+    IN_ORDER,      // In increasing order of the keys.
+    PRE_ORDER,     // Each node before its subtrees.
+    POST_ORDER     // Each node after its subtrees.
+};
+
+// Data Structure: TreeDumper
+class TreeDumper
+{
+    public:
+        static const size_t DEFAULT_BUFFER_SIZE = 1 << 16;
+
+        TreeDumper(FILE *output, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+        ~TreeDumper();
+
+        template <class Tree>
+        bool dumpText(Tree &tree, TraversalOrder order, char separator = '\n');
+        template <class Tree>
+        bool dumpBinary(Tree &tree, TraversalOrder order);
+        bool flush();
+
+    private:
+        // The longest text of any built-in integer: 20 digits and a sign.
+        static const size_t MAX_INTEGER_LENGTH = 21;
+
+        // Passed to the tree's visit() to write each key it is given:
+        struct TextWriter
+        {
+            template <class Key>
+            void operator()(const Key &key, int)
+            {
+                dumper->appendText(key);
+                dumper->append(&separator, 1);
+            }
+
+            TreeDumper *dumper;
+            char separator;
+        };
+
+        struct BinaryWriter
+        {
+            template <class Key>
+            void operator()(const Key &key, int)
+            {
+                dumper->append(reinterpret_cast<const char *>(&key),
+                               sizeof(Key));
+            }
+
+            TreeDumper *dumper;
+        };
+
+        // Copying would write the same buffered bytes twice:
+        TreeDumper(const TreeDumper &);
+        TreeDumper &operator=(const TreeDumper &);
+
+        void append(const char *data, size_t length);
+        template <class Integer>
+        typename enable_if<is_integral<Integer>::value>::type
+        appendText(const Integer &value);
+        void appendText(const string &value);
+        template <class T>
+        typename enable_if<!is_integral<T>::value>::type
+        appendText(const T &value);
+
+        FILE *m_output;
+        vector<char> m_buffer;
+        size_t m_used;  // Bytes of m_buffer waiting to be written.
+        bool m_failed;  // Whether any write since the last dump failed.
+};
+
+
+////
+//// Public Functions:
+////
+
+// Public Function: TreeDumper
+// Input: output - An open file to write to. The dumper does not close it.
+//        bufferSize - The number of bytes collected before each write.
+inline TreeDumper::TreeDumper(FILE *output, size_t bufferSize)
+    : m_buffer(bufferSize > 2 * MAX_INTEGER_LENGTH ? bufferSize :
+               2 * MAX_INTEGER_LENGTH)
+{
+    m_output = output;
+    m_used = 0;
+    m_failed = false;
+}
+
+inline TreeDumper::~TreeDumper()
+{
+    flush();
+}
+
+// Public Function: dumpText
+// Input: tree - The tree whose keys are written.
+//        order - The order in which the keys are written.
+//        separator - The character written after each key.
+// Output: Returns true if every byte was handed to the file.
+// Integer and string keys are written directly; other keys are written with
+// their operator<<, which is slower.
+template <class Tree>
+bool TreeDumper::dumpText(Tree &tree, TraversalOrder order, char separator)
+{
+    TextWriter writer;
+
+    writer.dumper = this;
+    writer.separator = separator;
+    m_failed = false;
+    tree.visit(order, writer);
+
+    return flush();
+}
+
+// Public Function: dumpBinary
+// Input: tree - The tree whose keys are written.
+//        order - The order in which the keys are written.
+// Output: Returns true if every byte was handed to the file.
+// Each key is written as its sizeof(Key) bytes in memory, with nothing in
+// between, so only keys that can be copied byte by byte (such as integers)
+// make sense here. An in-order dump can be read back into an array with
+// fread and given to buildFromSortedKeys.
+template <class Tree>
+bool TreeDumper::dumpBinary(Tree &tree, TraversalOrder order)
+{
+    BinaryWriter writer;
+
+    writer.dumper = this;
+    m_failed = false;
+    tree.visit(order, writer);
+
+    return flush();
+}
+
+// Public Function: flush
+// Input: None.
+// Output: Returns true if everything written since the last dump reached the
+//          file.
+// Hands the buffered bytes to the file. This is done at the end of every
+// dump, so it only needs calling directly to check the result early.
+inline bool TreeDumper::flush()
+{
+    if (m_used > 0)
+    {
+        if (fwrite(&m_buffer[0], 1, m_used, m_output) != m_used)
+        {
+            m_failed = true;
+        }
+
+        m_used = 0;
+    }
+
+    return !m_failed;
+}
+
+
+////
+//// Private functions:
+////
+
+// Private Function: append
+// Input: data - The bytes to write.
+//        length - The number of bytes.
+// Output: None.
+// Copies the bytes into the buffer, writing the buffer out first if they do
+// not fit. Anything larger than the whole buffer is written directly.
+inline void TreeDumper::append(const char *data, size_t length)
+{
+    if (m_used + length > m_buffer.size())
+    {
+        flush();
+
+        if (length > m_buffer.size())
+        {
+            if (fwrite(data, 1, length, m_output) != length)
+            {
+                m_failed = true;
+            }
+
+            return;
+        }
+    }
+
+    memcpy(&m_buffer[m_used], data, length);
+    m_used += length;
+}
+
+// Private Function: appendText
+// Input: value - An integer.
+// Output: None.
+// Writes the decimal digits of the value into the buffer, last digit first,
+// from the end of a space reserved for the longest possible number.
+template <class Integer>
+typename enable_if<is_integral<Integer>::value>::type
+TreeDumper::appendText(const Integer &value)
+{
+    typedef typename make_unsigned<Integer>::type Unsigned;
+
+    if (m_used + MAX_INTEGER_LENGTH > m_buffer.size())
+    {
+        flush();
+    }
+
+    // Negating in unsigned arithmetic also works for the most negative value:
+    bool negative = value < 0;
+    Unsigned magnitude = negative ? Unsigned(0) - Unsigned(value) :
+                         Unsigned(value);
+    char digits[MAX_INTEGER_LENGTH];
+    char *first = digits + MAX_INTEGER_LENGTH;
+
+    do
+    {
+        *--first = char('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    if (negative)
+    {
+        *--first = '-';
+    }
+
+    size_t length = digits + MAX_INTEGER_LENGTH - first;
+
+    memcpy(&m_buffer[m_used], first, length);
+    m_used += length;
+}
+
+// Private Function: appendText
+// Input: value - A string.
+// Output: None.
+inline void TreeDumper::appendText(const string &value)
+{
+    append(value.data(), value.size());
+}
+
+// Private Function: appendText
+// Input: value - Any value that can be written to an ostream.
+// Output: None.
+template <class T>
+typename enable_if<!is_integral<T>::value>::type
+TreeDumper::appendText(const T &value)
+{
+    ostringstream text;
+
+    text << value;
+    appendText(text.str());
+}
+
+#endif // TREE_DUMPER_H
@@ -0,0 +1,267 @@
+/*  File: TreeStatistics.h
+ *  This file contains the TreeStatisticsSnapshot structure and the two
+ *  statistics policies a BasicBinarySearchTree can be given as its fourth
+ *  template argument:
+ *  (a) NoStatistics, the default, whose functions do nothing. They are
+ *      inline and empty, so the compiler drops them, together with the path
+ *      lengths the tree would have passed to them, and the tree is exactly
+ *      as fast as one without any instrumentation.
+ *  (b) TreeStatistics, which counts what the tree does: how many nodes each
+ *      search, insertion and removal walked past, how many removals moved
+ *      a successor into the removed node's place, and how many nodes were
+ *      allocated and freed.
+ *  The counts are read with the tree's statistics() function, which returns
+ *  a copy of them in a TreeStatisticsSnapshot.
+ *
+ *  The counters are plain integers. A tree with TreeStatistics changes them
+ *  even on lookups, so unlike an uninstrumented tree it must not be searched
+ *  from several threads at once without a lock.
+ */
+
+#ifndef TREE_STATISTICS_H
+#define TREE_STATISTICS_H
+
+#include <cstddef>
+#include <cstring>
+
+using namespace std;
+
+// Data Structure: TreeStatisticsSnapshot
+// The counts collected by TreeStatistics at one moment. Each histogram is
+// indexed by path length, the number of nodes whose keys were compared with
+// the key searched for: searchLengths[3] is the number of searches that
+// compared against exactly three nodes. A search of an empty tree has length
+// zero.
+struct TreeStatisticsSnapshot
+{
+    // The longest path any tree can have. Longer paths, which cannot occur,
+    // would be counted in the last bucket.
+    static const int MAX_PATH_LENGTH = 96;
+
+    size_t searchLengths[MAX_PATH_LENGTH + 1];   // containsNode, findValue.
+    size_t insertionLengths[MAX_PATH_LENGTH + 1]; // Including repeated keys.
+    size_t removalLengths[MAX_PATH_LENGTH + 1];   // Including missing keys.
+    size_t successorReplacements; // Removals of a node with a right subtree.
+    size_t nodeAllocations;
+    size_t nodeFrees;
+
+    static size_t count(const size_t *histogram);
+    static double mean(const size_t *histogram);
+    static int percentile(const size_t *histogram, double fraction);
+};
+
+// Data Structure: NoStatistics
+// The policy that collects nothing.
+struct NoStatistics
+{
+    void recordSearch(int)
+    {
+    }
+
+    void recordInsertion(int)
+    {
+    }
+
+    void recordRemoval(int)
+    {
+    }
+
+    void recordSuccessorReplacement()
+    {
+    }
+
+    void recordAllocations(size_t)
+    {
+    }
+
+    void recordFrees(size_t)
+    {
+    }
+
+    // Nothing was counted, so every count is zero:
+    TreeStatisticsSnapshot snapshot() const
+    {
+        TreeStatisticsSnapshot counts;
+
+        memset(&counts, 0, sizeof(counts));
+        return counts;
+    }
+
+    void reset()
+    {
+    }
+};
+
+// Data Structure: TreeStatistics
+// The policy that counts.
+class TreeStatistics
+{
+    public:
+        TreeStatistics();
+
+        void recordSearch(int length);
+        void recordInsertion(int length);
+        void recordRemoval(int length);
+        void recordSuccessorReplacement();
+        void recordAllocations(size_t count);
+        void recordFrees(size_t count);
+        TreeStatisticsSnapshot snapshot() const;
+        void reset();
+
+    private:
+        static int bucket(int length);
+
+        TreeStatisticsSnapshot m_counts;
+};
+
+
+////
+//// Public Functions:
+////
+
+// Public Function: count
+// Input: histogram - One of the histograms of a snapshot.
+// Output: The number of operations counted in it.
+inline size_t TreeStatisticsSnapshot::count(const size_t *histogram)
+{
+    size_t total = 0;
+
+    for (int length = 0; length <= MAX_PATH_LENGTH; ++length)
+    {
+        total += histogram[length];
+    }
+
+    return total;
+}
+
+// Public Function: mean
+// Input: histogram - One of the histograms of a snapshot.
+// Output: The average path length, or 0 if nothing was counted.
+inline double TreeStatisticsSnapshot::mean(const size_t *histogram)
+{
+    double total = 0;
+    size_t operations = count(histogram);
+
+    for (int length = 0; length <= MAX_PATH_LENGTH; ++length)
+    {
+        total += static_cast<double>(length) * histogram[length];
+    }
+
+    return operations > 0 ? total / operations : 0;
+}
+
+// Public Function: percentile
+// Input: histogram - One of the histograms of a snapshot.
+//        fraction - Between 0 and 1, e.g. 0.99 for the 99th percentile.
+// Output: The shortest path length that at least this fraction of the
+//          counted operations did not exceed, or 0 if nothing was counted.
+inline int TreeStatisticsSnapshot::percentile(const size_t *histogram,
+                                              double fraction)
+{
+    double wanted = fraction * count(histogram);
+    size_t seen = 0;
+
+    for (int length = 0; length <= MAX_PATH_LENGTH; ++length)
+    {
+        seen += histogram[length];
+
+        if (seen > 0 && seen >= wanted)
+        {
+            return length;
+        }
+    }
+
+    return 0;
+}
+
+inline TreeStatistics::TreeStatistics()
+{
+    reset();
+}
+
+// Public Function: recordSearch
+// Input: length - The number of nodes a lookup compared its key with.
+// Output: None.
+inline void TreeStatistics::recordSearch(int length)
+{
+    ++m_counts.searchLengths[bucket(length)];
+}
+
+// Public Function: recordInsertion
+// Input: length - The number of nodes an insertion compared its key with.
+// Output: None.
+inline void TreeStatistics::recordInsertion(int length)
+{
+    ++m_counts.insertionLengths[bucket(length)];
+}
+
+// Public Function: recordRemoval
+// Input: length - The number of nodes a removal compared its key with while
+//                 looking for it, not counting the walk to the successor.
+// Output: None.
+inline void TreeStatistics::recordRemoval(int length)
+{
+    ++m_counts.removalLengths[bucket(length)];
+}
+
+// Public Function: recordSuccessorReplacement
+// Input: None.
+// Output: None.
+inline void TreeStatistics::recordSuccessorReplacement()
+{
+    ++m_counts.successorReplacements;
+}
+
+// Public Function: recordAllocations
+// Input: count - The number of nodes taken from the allocator.
+// Output: None.
+inline void TreeStatistics::recordAllocations(size_t count)
+{
+    m_counts.nodeAllocations += count;
+}
+
+// Public Function: recordFrees
+// Input: count - The number of nodes handed back to the allocator.
+// Output: None.
+inline void TreeStatistics::recordFrees(size_t count)
+{
+    m_counts.nodeFrees += count;
+}
+
+// Public Function: snapshot
+// Input: None.
+// Output: A copy of every count collected since construction or the last
+//          reset.
+inline TreeStatisticsSnapshot TreeStatistics::snapshot() const
+{
+    return m_counts;
+}
+
+// Public Function: reset
+// Input: None.
+// Output: None.
+// Sets every count back to zero.
+inline void TreeStatistics::reset()
+{
+    memset(&m_counts, 0, sizeof(m_counts));
+}
+
+
+////
+//// Private functions:
+////
+
+// Private Function: bucket
+// Input: length - A path length.
+// Output: The index of the histogram bucket that counts it.
+inline int TreeStatistics::bucket(int length)
+{
+    if (length > TreeStatisticsSnapshot::MAX_PATH_LENGTH)
+    {
+        return TreeStatisticsSnapshot::MAX_PATH_LENGTH;
+    }
+
+    return length;
+}
+
+#endif // TREE_STATISTICS_H
@@ -0,0 +1,531 @@
+/* File: BitParallelLongestCommonSubsequence.h
+ *
+ * This file contains the BitParallelLongestCommonSubsequence class template,
+ * which finds the length of the longest common subsequence of a fixed
+ * sequence, the pattern, and any other sequence, the text, for sequences of a
+ * one byte integral type such as char or uint8_t: bytes, letters of DNA or
+ * other small alphabets.
+ *
+ * It uses the bit-parallel algorithm of Allison and Dix in the form given by
+ * Hyyro. Column j of the dynamic programming table, the lengths for the first
+ * j elements of the text against every prefix of the pattern, goes up by
+ * either zero or one from each row to the next, so the whole column fits in
+ * one bit per row, in a bit vector V that has a bit clear where the column
+ * goes up. For every symbol the pattern has, a match mask with a bit set at
+ * every row where the pattern has that symbol is computed once. Then the next
+ * column is
+ *
+ *     U = V & match mask of the next element of the text
+ *     V = (V + U) | (V - U)
+ *
+ * where the addition carries from lower to higher rows. The length is the
+ * number of clear bits of the last column. A 64-bit word of V therefore
+ * advances 64 cells of the table with a handful of instructions, and a
+ * pattern longer than 64 elements takes one word per 64 elements, with the
+ * carry of the addition passed from each word to the next.
+ *
+ * On x86-64 processors with AVX2 or AVX-512 the words are processed four or
+ * eight at a time, one per vector lane, so one instruction advances 256 or
+ * 512 cells. The carry from a word is needed by the next word of the same
+ * column, so the lanes work along an anti-diagonal: while the lane of word w
+ * advances column j, the lane of word w + 1 advances column j - 1, with the
+ * carry word w produced for it a step earlier. The fastest kernel the
+ * processor supports is chosen when the program runs, so no compiler flags
+ * are needed.
+ *
+ * The match masks take (s + 1) * ceil(m / 64) words, where m is the length of
+ * the pattern and s the number of different symbols it has. Finding the
+ * length for a text of n elements takes O(n * m / 64) time and O(n) memory
+ * for the vector kernels. The vector kernels index the match masks with
+ * 32-bit offsets, which limits the pattern to about 500 million elements.
+ *
+ * Compile with -std=c++11. The vector kernels need GCC or Clang.
+ */
+
+#ifndef BIT_PARALLEL_LONGEST_COMMON_SUBSEQUENCE_H
+#define BIT_PARALLEL_LONGEST_COMMON_SUBSEQUENCE_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Data Structure: BitParallelKernel
+// The ways BitParallelLongestCommonSubsequence can advance its bit vectors.
+enum BitParallelKernel
+{
+    SCALAR_KERNEL,  // One 64-bit word at a time, on any processor.
+    AVX2_KERNEL,    // Four words at a time.
+    AVX512_KERNEL   // Eight words at a time.
+};
+
+// Data Structure: BitParallelLongestCommonSubsequence
+// The match masks of a pattern, from which the length of its longest common
+// subsequence with any number of texts can be found.
+template <class T>
+class BitParallelLongestCommonSubsequence
+{
+    static_assert(is_integral<T>::value && sizeof(T) == 1 &&
+                  !is_same<T, bool>::value,
+                  "The elements must be of a one byte integral type.");
+
+    public:
+        explicit BitParallelLongestCommonSubsequence(const vector<T> &pattern);
+
+        size_t patternSize() const;
+        size_t length(const vector<T> &text) const;
+        size_t length(const vector<T> &text, BitParallelKernel kernel) const;
+
+        static BitParallelKernel fastestKernel();
+        static bool kernelIsSupported(BitParallelKernel kernel);
+
+    private:
+        // The rows of the match masks are padded to a multiple of the
+        // widest vector, so that a vector kernel can read a whole vector
+        // of words from any row:
+        static const size_t ROW_ALIGNMENT = 8;
+
+        size_t lengthScalar(const T *text, size_t size) const;
+#ifdef __x86_64__
+        void findTextOffsets(const T *text, size_t size, size_t lanes,
+                             vector<uint32_t> &offsets) const;
+        size_t lengthAvx2(const T *text, size_t size) const;
+        size_t lengthAvx512(const T *text, size_t size) const;
+#endif
+        size_t countClearBits(const uint64_t *columnBits) const;
+
+        size_t m_patternSize;
+        size_t m_words;    // The number of words of a bit vector.
+        size_t m_rowWords; // m_words rounded up to ROW_ALIGNMENT.
+
+        // m_symbolOffsets[s] is the index in m_matchMasks of the match mask
+        // of symbol s. Symbols the pattern does not have share the first
+        // mask, which has no bits set.
+        uint32_t m_symbolOffsets[256];
+        vector<uint64_t> m_matchMasks;
+};
+
+// Function findLongestCommonSubsequenceLengthBitParallel
+//
+// Inputs: sequence1 - The first of two sequences of a one byte integral type.
+//         sequence2 - The second of two sequences of the same type.
+//
+// Output: Returns the length of the longest common subsequence of the two
+//         sequences, the same as findLongestCommonSubsequenceLength.
+//
+// The shorter sequence is made the pattern, so that the match masks take as
+// little memory as possible.
+template <class T>
+size_t
+findLongestCommonSubsequenceLengthBitParallel(const vector<T> &sequence1,
+                                              const vector<T> &sequence2)
+{
+    bool patternIsSequence1 = sequence1.size() <= sequence2.size();
+    BitParallelLongestCommonSubsequence<T> search(patternIsSequence1 ?
+                                                  sequence1 : sequence2);
+
+    return search.length(patternIsSequence1 ? sequence2 : sequence1);
+}
+
+
+////
+//// Public Functions:
+////
+
+// Public Function: BitParallelLongestCommonSubsequence
+// Inputs: pattern - The sequence to compare texts with.
+// Output: None.
+// Computes the match mask of every symbol the pattern has.
+template <class T>
+BitParallelLongestCommonSubsequence<T>::BitParallelLongestCommonSubsequence(
+    const vector<T> &pattern)
+{
+    size_t symbols = 0;
+
+    m_patternSize = pattern.size();
+    m_words = (m_patternSize + 63) / 64;
+    m_rowWords = (m_words + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+
+    for (int symbol = 0; symbol < 256; ++symbol)
+    {
+        m_symbolOffsets[symbol] = 0;
+    }
+
+    // Number the symbols in the order they first appear, from one:
+    for (size_t i = 0; i < m_patternSize; ++i)
+    {
+        uint8_t symbol = static_cast<uint8_t>(pattern[i]);
+
+        if (m_symbolOffsets[symbol] == 0)
+        {
+            m_symbolOffsets[symbol] = static_cast<uint32_t>(++symbols);
+        }
+    }
+
+    for (int symbol = 0; symbol < 256; ++symbol)
+    {
+        m_symbolOffsets[symbol] *= static_cast<uint32_t>(m_rowWords);
+    }
+
+    m_matchMasks.assign((symbols + 1) * m_rowWords, 0);
+
+    for (size_t i = 0; i < m_patternSize; ++i)
+    {
+        uint8_t symbol = static_cast<uint8_t>(pattern[i]);
+
+        m_matchMasks[m_symbolOffsets[symbol] + i / 64] |= uint64_t(1) <<
+                                                          (i % 64);
+    }
+}
+
+// Public Function: patternSize
+// Inputs: None.
+// Output: The number of elements of the pattern.
+template <class T>
+inline size_t BitParallelLongestCommonSubsequence<T>::patternSize() const
+{
+    return m_patternSize;
+}
+
+// Public Function: length
+// Inputs: text - A sequence to compare with the pattern.
+// Output: Returns the length of the longest common subsequence of the
+//          pattern and the text.
+// Uses the fastest kernel the processor supports.
+template <class T>
+inline size_t BitParallelLongestCommonSubsequence<T>::length(
+    const vector<T> &text) const
+{
+    return length(text, fastestKernel());
+}
+
+// Public Function: length
+// Inputs: text - A sequence to compare with the pattern.
+//         kernel - The kernel to use, which the processor must support.
+// Output: Returns the length of the longest common subsequence of the
+//          pattern and the text.
+// A pattern of fewer words than a vector has lanes gains nothing from the
+// vector kernels, so the scalar kernel is used for it instead.
+template <class T>
+size_t BitParallelLongestCommonSubsequence<T>::length(
+    const vector<T> &text, BitParallelKernel kernel) const
+{
+    if (m_patternSize == 0 || text.empty())
+    {
+        return 0;
+    }
+
+#ifdef __x86_64__
+    if (kernel == AVX512_KERNEL && m_words >= 8)
+    {
+        return lengthAvx512(text.data(), text.size());
+    }
+
+    if (kernel != SCALAR_KERNEL && m_words >= 4)
+    {
+        return lengthAvx2(text.data(), text.size());
+    }
+#endif
+
+    return lengthScalar(text.data(), text.size());
+}
+
+// Public Function: fastestKernel
+// Inputs: None.
+// Output: The fastest kernel the processor running the program supports.
+template <class T>
+BitParallelKernel BitParallelLongestCommonSubsequence<T>::fastestKernel()
+{
+    if (kernelIsSupported(AVX512_KERNEL))
+    {
+        return AVX512_KERNEL;
+    }
+
+    if (kernelIsSupported(AVX2_KERNEL))
+    {
+        return AVX2_KERNEL;
+    }
+
+    return SCALAR_KERNEL;
+}
+
+// Public Function: kernelIsSupported
+// Inputs: kernel - One of the kernels.
+// Output: True if the processor running the program can run the kernel.
+template <class T>
+bool BitParallelLongestCommonSubsequence<T>::kernelIsSupported(
+    BitParallelKernel kernel)
+{
+#ifdef __x86_64__
+    if (kernel == AVX512_KERNEL)
+    {
+        return __builtin_cpu_supports("avx512f");
+    }
+
+    if (kernel == AVX2_KERNEL)
+    {
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+
+    return kernel == SCALAR_KERNEL;
+}
+
+
+////
+//// Private functions:
+////
+
+// Private Function: lengthScalar
+// Inputs: text, size - The elements of the text and their number.
+// Output: The length of the longest common subsequence.
+template <class T>
+size_t BitParallelLongestCommonSubsequence<T>::lengthScalar(const T *text,
+                                                            size_t size) const
+{
+    vector<uint64_t> column(m_words, ~uint64_t(0));
+    uint64_t *bits = column.data();
+    const uint64_t *masks = m_matchMasks.data();
+
+    // With a single word there is no carry to pass on:
+    if (m_words == 1)
+    {
+        uint64_t v = ~uint64_t(0);
+
+        for (size_t j = 0; j < size; ++j)
+        {
+            uint64_t match = masks[m_symbolOffsets[uint8_t(text[j])]];
+            uint64_t u = v & match;
+
+            v = (v + u) | (v & ~match);
+        }
+
+        bits[0] = v;
+        return countClearBits(bits);
+    }
+
+    for (size_t j = 0; j < size; ++j)
+    {
+        const uint64_t *match = masks + m_symbolOffsets[uint8_t(text[j])];
+        uint64_t carry = 0;
+
+        // V - U is V & ~match, since U holds only bits of V:
+        for (size_t word = 0; word < m_words; ++word)
+        {
+            uint64_t v = bits[word];
+            uint64_t u = v & match[word];
+            uint64_t sum = v + u;
+            uint64_t carried = sum + carry;
+
+            carry = (sum < u) | (carried < carry);
+            bits[word] = carried | (v & ~match[word]);
+        }
+    }
+
+    return countClearBits(bits);
+}
+
+#ifdef __x86_64__
+// Private Function: findTextOffsets
+// Inputs: text, size - The elements of the text and their number.
+//         lanes - The number of lanes of the vector kernel.
+//         offsets - Set to the offsets of the match masks of the text, with
+//                   lanes - 1 offsets of the empty mask before and after.
+// Output: None.
+// The lanes work on consecutive columns in reverse order, so a kernel reads
+// the offsets of all its lanes with one load.
+template <class T>
+void BitParallelLongestCommonSubsequence<T>::findTextOffsets(
+    const T *text, size_t size, size_t lanes, vector<uint32_t> &offsets) const
+{
+    offsets.assign(size + 2 * (lanes - 1), 0);
+
+    for (size_t j = 0; j < size; ++j)
+    {
+        offsets[j + lanes - 1] = m_symbolOffsets[uint8_t(text[j])];
+    }
+}
+
+// Private Function: lengthAvx2
+// Inputs: text, size - The elements of the text and their number.
+// Output: The length of the longest common subsequence.
+//
+// The words of the bit vector are processed in stripes of four, one word per
+// lane, with lane k holding word 3 - k of the stripe. At step t lane k
+// advances column t + k - 3, so the lane of each word is one column behind
+// the lane of the word below it, and receives that word's carry for its
+// column from the step before. Lanes outside the text read the empty mask,
+// which leaves their word unchanged and carries nothing. The carries out of
+// the top word of a stripe are kept for every column, and are the carries
+// into the bottom word of the next stripe.
+template <class T>
+__attribute__((target("avx2")))
+size_t BitParallelLongestCommonSubsequence<T>::lengthAvx2(const T *text,
+                                                          size_t size) const
+{
+    const size_t LANES = 4;
+    vector<uint32_t> offsets;
+    vector<uint64_t> carries(size + LANES, 0);
+    vector<uint64_t> column(m_rowWords);
+    const long long *masks = reinterpret_cast<const long long *>(
+                                 m_matchMasks.data());
+    // There is no unsigned comparison of 64-bit lanes, so both sides of one
+    // are moved into the signed range by flipping their top bits:
+    const __m256i signBit = _mm256_set1_epi64x(
+                                static_cast<long long>(uint64_t(1) << 63));
+    const __m256i one = _mm256_set1_epi64x(1);
+
+    findTextOffsets(text, size, LANES, offsets);
+
+    for (size_t stripe = 0; stripe < m_words; stripe += LANES)
+    {
+        __m128i laneWords = _mm_setr_epi32(stripe + 3, stripe + 2,
+                                           stripe + 1, stripe);
+        __m256i bits = _mm256_set1_epi64x(-1);
+        __m256i carryIn = _mm256_setr_epi64x(0, 0, 0, carries[0]);
+
+        for (size_t step = 0; step < size + LANES - 1; ++step)
+        {
+            __m128i indices = _mm_add_epi32(laneWords,
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+                                    offsets.data() + step)));
+            __m256i match = _mm256_i32gather_epi64(masks, indices, 8);
+            __m256i u = _mm256_and_si256(bits, match);
+            __m256i sum = _mm256_add_epi64(bits, u);
+            __m256i carried = _mm256_add_epi64(sum, carryIn);
+            __m256i sumCarries = _mm256_cmpgt_epi64(
+                                     _mm256_xor_si256(u, signBit),
+                                     _mm256_xor_si256(sum, signBit));
+            __m256i carriedCarries = _mm256_cmpgt_epi64(
+                                         _mm256_xor_si256(carryIn, signBit),
+                                         _mm256_xor_si256(carried, signBit));
+            __m256i carryOut = _mm256_and_si256(
+                                   _mm256_or_si256(sumCarries,
+                                                   carriedCarries), one);
+
+            bits = _mm256_or_si256(carried, _mm256_andnot_si256(match, bits));
+
+            if (step >= LANES - 1)
+            {
+                carries[step - (LANES - 1)] = _mm_cvtsi128_si64(
+                    _mm256_castsi256_si128(carryOut));
+            }
+
+            // Each lane takes the carry of the lane of the word below, and
+            // the bottom word the carry of the previous stripe:
+            carryIn = _mm256_blend_epi32(
+                          _mm256_permute4x64_epi64(carryOut,
+                                                   _MM_SHUFFLE(0, 3, 2, 1)),
+                          _mm256_set1_epi64x(carries[step + 1]), 0xC0);
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(column.data() +
+                                                        stripe),
+                            _mm256_permute4x64_epi64(bits,
+                                                     _MM_SHUFFLE(0, 1, 2, 3)));
+    }
+
+    return countClearBits(column.data());
+}
+
+// Private Function: lengthAvx512
+// Inputs: text, size - The elements of the text and their number.
+// Output: The length of the longest common subsequence.
+// The same as lengthAvx2, with stripes of eight words.
+//
+// GCC 12 wrongly warns that the AVX-512 intrinsics use an uninitialized
+// value (GCC bug 105593), so the warning is turned off for this function.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+template <class T>
+__attribute__((target("avx512f")))
+size_t BitParallelLongestCommonSubsequence<T>::lengthAvx512(
+    const T *text, size_t size) const
+{
+    const size_t LANES = 8;
+    vector<uint32_t> offsets;
+    vector<uint64_t> carries(size + LANES, 0);
+    vector<uint64_t> column(m_rowWords);
+    const long long *masks = reinterpret_cast<const long long *>(
+                                 m_matchMasks.data());
+    const __m512i reverse = _mm512_setr_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+    const __m512i zero = _mm512_setzero_si512();
+
+    findTextOffsets(text, size, LANES, offsets);
+
+    for (size_t stripe = 0; stripe < m_words; stripe += LANES)
+    {
+        __m256i laneWords = _mm256_setr_epi32(stripe + 7, stripe + 6,
+                                              stripe + 5, stripe + 4,
+                                              stripe + 3, stripe + 2,
+                                              stripe + 1, stripe);
+        __m512i bits = _mm512_set1_epi64(-1);
+        __m512i carryIn = _mm512_maskz_set1_epi64(0x80, carries[0]);
+
+        for (size_t step = 0; step < size + LANES - 1; ++step)
+        {
+            __m256i indices = _mm256_add_epi32(laneWords,
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(
+                                       offsets.data() + step)));
+            __m512i match = _mm512_i32gather_epi64(indices, masks, 8);
+            __m512i u = _mm512_and_si512(bits, match);
+            __m512i sum = _mm512_add_epi64(bits, u);
+            __m512i carried = _mm512_add_epi64(sum, carryIn);
+            __mmask8 carryOut = _mm512_cmplt_epu64_mask(sum, u) |
+                                _mm512_cmplt_epu64_mask(carried, carryIn);
+            __m512i carryBits = _mm512_maskz_set1_epi64(carryOut, 1);
+
+            bits = _mm512_or_si512(carried, _mm512_andnot_si512(match, bits));
+
+            if (step >= LANES - 1)
+            {
+                carries[step - (LANES - 1)] = carryOut & 1;
+            }
+
+            carryIn = _mm512_alignr_epi64(
+                          _mm512_mask_set1_epi64(zero, 1, carries[step + 1]),
+                          carryBits, 1);
+        }
+
+        _mm512_storeu_si512(column.data() + stripe,
+                            _mm512_permutexvar_epi64(reverse, bits));
+    }
+
+    return countClearBits(column.data());
+}
+#pragma GCC diagnostic pop
+#endif
+
+// Private Function: countClearBits
+// Inputs: columnBits - The bit vector of the last column.
+// Output: The number of its bits, among the first m_patternSize, that are
+//          clear.
+template <class T>
+size_t BitParallelLongestCommonSubsequence<T>::countClearBits(
+    const uint64_t *columnBits) const
+{
+    size_t setBits = 0;
+
+    for (size_t word = 0; word + 1 < m_words; ++word)
+    {
+        setBits += __builtin_popcountll(columnBits[word]);
+    }
+
+    // Carries can reach the bits past the end of the pattern, which count
+    // for nothing:
+    size_t lastBits = m_patternSize - 64 * (m_words - 1);
+    uint64_t lastMask = lastBits == 64 ? ~uint64_t(0) :
+                                         (uint64_t(1) << lastBits) - 1;
+
+    setBits += __builtin_popcountll(columnBits[m_words - 1] & lastMask);
+
+    return m_patternSize - setBits;
+}
+
+#endif // BIT_PARALLEL_LONGEST_COMMON_SUBSEQUENCE_H
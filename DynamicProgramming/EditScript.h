@@ -0,0 +1,494 @@
+/* File: EditScript.h
+ *
+ * This file contains findEditScript, which finds how to turn one sequence
+ * into another with as few insertions and deletions of elements as possible,
+ * the way a diff program compares two versions of a file. The elements that
+ * are kept form a longest common subsequence of the two sequences, though
+ * not necessarily the one findLongestCommonSubsequence would choose.
+ *
+ * The edit script is not returned as a whole. It is passed, in order, to a
+ * callback as hunks: runs of elements that are kept, deleted from sequence1
+ * or inserted from sequence2. Each hunk is passed on as soon as it is known
+ * to be complete, so the script of two huge sequences never has to fit in
+ * memory.
+ *
+ * It uses Myers' O((n + m) * D) algorithm, where D is the number of elements
+ * inserted and deleted, in its linear space form. Myers' algorithm follows
+ * the paths through the edit graph with d differences for d = 0, 1, 2, ...,
+ * each as far along its diagonal as equal elements let it go, so sequences
+ * that differ in a handful of places are compared in close to linear time.
+ * The linear space form runs the search from both ends of the sequences at
+ * once until the two meet at a "middle snake", a point that some shortest
+ * script passes through, and then finds the scripts of the two halves on
+ * either side of it in the same way. Common prefixes and suffixes are
+ * skipped before each search.
+ *
+ * The furthest points reached on each diagonal are kept in arrays that grow
+ * with d, so besides the recursion, which is O(log D) deep, the memory used
+ * is O(D).
+ *
+ * Compile with -std=c++11.
+ */
+
+#ifndef EDIT_SCRIPT_H
+#define EDIT_SCRIPT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Data Structure: EditOperation
+enum EditOperation
+{
+    KEEP_ELEMENTS,   // Elements of sequence1 that equal those of sequence2.
+    DELETE_ELEMENTS, // Elements of sequence1 not in sequence2.
+    INSERT_ELEMENTS  // Elements of sequence2 not in sequence1.
+};
+
+// Data Structure: EditHunk
+// A run of elements with the same operation. position1 and position2 are
+// where the run starts in sequence1 and sequence2: a deletion removes
+// sequence1[position1, position1 + length) at position2 of sequence2, and an
+// insertion adds sequence2[position2, position2 + length) before position1
+// of sequence1. A deletion always comes before an insertion at the same
+// place.
+struct EditHunk
+{
+    EditOperation operation;
+    size_t position1;
+    size_t position2;
+    size_t length;
+};
+
+// Data Structure: DiagonalVector
+// The furthest point reached on each diagonal k, for k from -d to d, or -1
+// for diagonals not reached. It grows as d does.
+class DiagonalVector
+{
+    public:
+        void reset();
+        void reserve(ptrdiff_t diagonals);
+        ptrdiff_t get(ptrdiff_t diagonal) const;
+        ptrdiff_t &operator[](ptrdiff_t diagonal);
+
+    private:
+        vector<ptrdiff_t> m_values;
+        ptrdiff_t m_center; // The index of diagonal 0 in m_values.
+};
+
+// Data Structure: EditScriptWriter
+// Joins consecutive hunks that keep elements, and the deletions and the
+// insertions between two such hunks, before they are passed to the callback.
+template <class Callback>
+class EditScriptWriter
+{
+    public:
+        explicit EditScriptWriter(Callback &callback);
+
+        void write(EditOperation operation, size_t position1,
+                   size_t position2, size_t length);
+        void flush();
+        size_t changes() const;
+
+    private:
+        void pass(EditOperation operation, size_t position1,
+                  size_t position2, size_t length);
+
+        Callback &m_callback;
+        // Elements not yet passed on, from position1 and position2. Either
+        // some are kept, or some are deleted or inserted:
+        size_t m_position1;
+        size_t m_position2;
+        size_t m_kept;
+        size_t m_deleted;
+        size_t m_inserted;
+        size_t m_changes; // Elements inserted or deleted so far.
+};
+
+
+////
+//// Public Functions:
+////
+
+// Public Function: reset
+// Inputs: None.
+// Output: None.
+// Forgets every diagonal, keeping the memory for the next search.
+inline void DiagonalVector::reset()
+{
+    m_values.assign(8, -1);
+    m_center = 4;
+}
+
+// Public Function: reserve
+// Inputs: diagonals - The largest diagonal, and the negative of the smallest,
+//                     that operator[] is about to be given.
+// Output: None.
+inline void DiagonalVector::reserve(ptrdiff_t diagonals)
+{
+    ptrdiff_t size = static_cast<ptrdiff_t>(m_values.size());
+
+    if (m_center - diagonals >= 0 && m_center + diagonals < size)
+    {
+        return;
+    }
+
+    vector<ptrdiff_t> values(2 * size + 4 * diagonals, -1);
+    ptrdiff_t center = static_cast<ptrdiff_t>(values.size()) / 2;
+
+    copy(m_values.begin(), m_values.end(),
+         values.begin() + (center - m_center));
+    m_values.swap(values);
+    m_center = center;
+}
+
+// Public Function: get
+// Inputs: diagonal - A diagonal.
+// Output: The furthest point reached on it, or -1 if there is none.
+inline ptrdiff_t DiagonalVector::get(ptrdiff_t diagonal) const
+{
+    ptrdiff_t index = m_center + diagonal;
+
+    if (index < 0 || index >= static_cast<ptrdiff_t>(m_values.size()))
+    {
+        return -1;
+    }
+
+    return m_values[index];
+}
+
+// Public Function: operator[]
+// Inputs: diagonal - A diagonal within the range last reserved.
+// Output: The furthest point reached on it.
+inline ptrdiff_t &DiagonalVector::operator[](ptrdiff_t diagonal)
+{
+    return m_values[m_center + diagonal];
+}
+
+template <class Callback>
+EditScriptWriter<Callback>::EditScriptWriter(Callback &callback)
+    : m_callback(callback), m_position1(0), m_position2(0), m_kept(0),
+      m_deleted(0), m_inserted(0), m_changes(0)
+{
+}
+
+// Public Function: write
+// Inputs: operation, position1, position2, length - A hunk, which follows the
+//                                                    hunks written before.
+// Output: None.
+template <class Callback>
+void EditScriptWriter<Callback>::write(EditOperation operation,
+                                       size_t position1, size_t position2,
+                                       size_t length)
+{
+    if (length == 0)
+    {
+        return;
+    }
+
+    bool keep = operation == KEEP_ELEMENTS;
+
+    if (keep ? m_deleted + m_inserted > 0 : m_kept > 0)
+    {
+        flush();
+    }
+
+    if (m_kept + m_deleted + m_inserted == 0)
+    {
+        m_position1 = position1;
+        m_position2 = position2;
+    }
+
+    if (keep)
+    {
+        m_kept += length;
+        return;
+    }
+
+    m_changes += length;
+
+    if (operation == DELETE_ELEMENTS)
+    {
+        m_deleted += length;
+    }
+    else
+    {
+        m_inserted += length;
+    }
+}
+
+// Public Function: flush
+// Inputs: None.
+// Output: None.
+// Passes on the hunks held back, if any.
+template <class Callback>
+void EditScriptWriter<Callback>::flush()
+{
+    pass(KEEP_ELEMENTS, m_position1, m_position2, m_kept);
+    pass(DELETE_ELEMENTS, m_position1, m_position2, m_deleted);
+    pass(INSERT_ELEMENTS, m_position1 + m_deleted, m_position2, m_inserted);
+    m_kept = 0;
+    m_deleted = 0;
+    m_inserted = 0;
+}
+
+// Public Function: changes
+// Inputs: None.
+// Output: The number of elements inserted or deleted by the hunks written.
+template <class Callback>
+inline size_t EditScriptWriter<Callback>::changes() const
+{
+    return m_changes;
+}
+
+
+////
+//// Private functions:
+////
+
+// Private Function: pass
+// Inputs: operation, position1, position2, length - A hunk.
+// Output: None.
+// Passes the hunk to the callback, unless it is empty.
+template <class Callback>
+void EditScriptWriter<Callback>::pass(EditOperation operation,
+                                      size_t position1, size_t position2,
+                                      size_t length)
+{
+    if (length > 0)
+    {
+        EditHunk hunk = {operation, position1, position2, length};
+
+        m_callback(static_cast<const EditHunk &>(hunk));
+    }
+}
+
+
+// Function findMiddleSnake
+//
+// Inputs: sequence1, size1 - The elements of the first sequence.
+//         sequence2, size2 - The elements of the second sequence.
+//         forward, backward - Scratch space.
+//         splitPosition1, splitPosition2 - Set to a point, in the two
+//                                          sequences, that a shortest edit
+//                                          script passes through.
+//
+// Output: Returns false if the sequences have no element in common.
+//
+// The search from the start of the sequences advances on the diagonals
+// k = x - y, where x and y are positions in sequence1 and sequence2, and the
+// search from their ends on the same diagonals counted from the end. When the
+// difference of the lengths is odd the two searches can first meet while the
+// forward one is advancing, and otherwise while the backward one is. Both
+// sequences must be non-empty and differ in their first and last elements.
+template <class T>
+bool findMiddleSnake(const T *sequence1, ptrdiff_t size1,
+                     const T *sequence2, ptrdiff_t size2,
+                     DiagonalVector &forward, DiagonalVector &backward,
+                     ptrdiff_t &splitPosition1, ptrdiff_t &splitPosition2)
+{
+    ptrdiff_t maximumDifferences = (size1 + size2 + 1) / 2;
+    ptrdiff_t delta = size1 - size2;
+    bool meetForward = (delta & 1) != 0;
+
+    // Diagonals that ran off the end of a sequence are not searched again:
+    ptrdiff_t forwardStart = 0, forwardEnd = 0;
+    ptrdiff_t backwardStart = 0, backwardEnd = 0;
+
+    forward.reset();
+    backward.reset();
+    forward[1] = 0;
+    backward[1] = 0;
+
+    for (ptrdiff_t d = 0; d < maximumDifferences; ++d)
+    {
+        forward.reserve(d + 1);
+        backward.reserve(d + 1);
+
+        for (ptrdiff_t k = -d + forwardStart; k <= d - forwardEnd; k += 2)
+        {
+            ptrdiff_t x;
+
+            if (k == -d || (k != d && forward[k - 1] < forward[k + 1]))
+            {
+                x = forward[k + 1];
+            }
+            else
+            {
+                x = forward[k - 1] + 1;
+            }
+
+            ptrdiff_t y = x - k;
+
+            while (x < size1 && y < size2 && sequence1[x] == sequence2[y])
+            {
+                ++x;
+                ++y;
+            }
+
+            forward[k] = x;
+
+            if (x > size1)
+            {
+                forwardEnd += 2;
+            }
+            else if (y > size2)
+            {
+                forwardStart += 2;
+            }
+            else if (meetForward)
+            {
+                ptrdiff_t reached = backward.get(delta - k);
+
+                if (reached != -1 && x >= size1 - reached)
+                {
+                    splitPosition1 = x;
+                    splitPosition2 = y;
+                    return true;
+                }
+            }
+        }
+
+        for (ptrdiff_t k = -d + backwardStart; k <= d - backwardEnd; k += 2)
+        {
+            ptrdiff_t x;
+
+            if (k == -d || (k != d && backward[k - 1] < backward[k + 1]))
+            {
+                x = backward[k + 1];
+            }
+            else
+            {
+                x = backward[k - 1] + 1;
+            }
+
+            ptrdiff_t y = x - k;
+
+            while (x < size1 && y < size2 &&
+                   sequence1[size1 - x - 1] == sequence2[size2 - y - 1])
+            {
+                ++x;
+                ++y;
+            }
+
+            backward[k] = x;
+
+            if (x > size1)
+            {
+                backwardEnd += 2;
+            }
+            else if (y > size2)
+            {
+                backwardStart += 2;
+            }
+            else if (!meetForward)
+            {
+                ptrdiff_t reached = forward.get(delta - k);
+
+                if (reached != -1 && reached >= size1 - x)
+                {
+                    splitPosition1 = reached;
+                    splitPosition2 = reached - (delta - k);
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+// Function writeEditScript
+//
+// Inputs: sequence1 - The first sequence.
+//         begin1, end1 - The part [begin1, end1) of it to compare.
+//         sequence2 - The second sequence.
+//         begin2, end2 - The part [begin2, end2) of it to compare.
+//         writer - Receives the hunks of the edit script of the two parts.
+//         forward, backward - Scratch space for findMiddleSnake.
+//
+// Output: None.
+template <class T, class Callback>
+void writeEditScript(const vector<T> &sequence1, size_t begin1, size_t end1,
+                     const vector<T> &sequence2, size_t begin2, size_t end2,
+                     EditScriptWriter<Callback> &writer,
+                     DiagonalVector &forward, DiagonalVector &backward)
+{
+    size_t prefix = 0, suffix = 0;
+
+    while (begin1 + prefix < end1 && begin2 + prefix < end2 &&
+           sequence1[begin1 + prefix] == sequence2[begin2 + prefix])
+    {
+        ++prefix;
+    }
+
+    writer.write(KEEP_ELEMENTS, begin1, begin2, prefix);
+    begin1 += prefix;
+    begin2 += prefix;
+
+    while (end1 - suffix > begin1 && end2 - suffix > begin2 &&
+           sequence1[end1 - suffix - 1] == sequence2[end2 - suffix - 1])
+    {
+        ++suffix;
+    }
+
+    end1 -= suffix;
+    end2 -= suffix;
+
+    ptrdiff_t split1, split2;
+
+    if (begin1 == end1 || begin2 == end2 ||
+        !findMiddleSnake(sequence1.data() + begin1,
+                         static_cast<ptrdiff_t>(end1 - begin1),
+                         sequence2.data() + begin2,
+                         static_cast<ptrdiff_t>(end2 - begin2),
+                         forward, backward, split1, split2))
+    {
+        writer.write(DELETE_ELEMENTS, begin1, begin2, end1 - begin1);
+        writer.write(INSERT_ELEMENTS, end1, begin2, end2 - begin2);
+    }
+    else
+    {
+        writeEditScript(sequence1, begin1, begin1 + split1,
+                        sequence2, begin2, begin2 + split2,
+                        writer, forward, backward);
+        writeEditScript(sequence1, begin1 + split1, end1,
+                        sequence2, begin2 + split2, end2,
+                        writer, forward, backward);
+    }
+
+    writer.write(KEEP_ELEMENTS, end1, end2, suffix);
+}
+
+// Function findEditScript
+//
+// Inputs: sequence1 - The sequence to be edited.
+//         sequence2 - The sequence it is to be turned into.
+//         callback - Called with each hunk of the edit script, as a const
+//                    EditHunk &, in order from the start of the sequences.
+//
+// Output: Returns the number of elements the script inserts or deletes.
+//
+// Two consecutive hunks never have the same operation, and the elements
+// deleted and inserted between two hunks that keep elements are passed on as
+// one deletion followed by one insertion. T needs only a check for equality,
+// as for findLongestCommonSubsequence. Any function object, for instance a
+// lambda, can be the callback.
+template <class T, class Callback>
+size_t findEditScript(const vector<T> &sequence1, const vector<T> &sequence2,
+                      Callback callback)
+{
+    EditScriptWriter<Callback> writer(callback);
+    DiagonalVector forward, backward;
+
+    writeEditScript(sequence1, 0, sequence1.size(),
+                    sequence2, 0, sequence2.size(),
+                    writer, forward, backward);
+    writer.flush();
+
+    return writer.changes();
+}
+
+#endif // EDIT_SCRIPT_H
@@ -0,0 +1,212 @@
+/* File: FileDiff.cpp
+ *
+ * This file contains driver code for diffMappedFiles in FileDiff.h: a small
+ * diff program that prints the lines to change to turn one file into
+ * another, in the "normal" format of the diff command. Hunks are printed as
+ * they are found, so files of any size can be compared.
+ *
+ * Usage: FileDiff file1 file2 [recordSize]
+ *
+ * Given a record size the files are compared as records of that many bytes,
+ * and only the positions of the records that change are printed.
+ *
+ * Compile with -std=c++11.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include "FileDiff.h"
+
+using namespace std;
+
+// Data Structure: NormalDiffPrinter
+// Prints hunks in the normal diff format. A deletion is held back until the
+// next hunk shows whether it is part of a change.
+class NormalDiffPrinter
+{
+    public:
+        explicit NormalDiffPrinter(bool printLines);
+
+        void operator()(const FileHunk &hunk);
+        void flush();
+        size_t changes() const;
+
+    private:
+        void printRange(size_t first, size_t count);
+        void printLines(char marker, const char *bytes, size_t length);
+
+        bool m_printLines;
+        FileHunk m_deletion; // Of no tokens if none is held back.
+        size_t m_changes;
+};
+
+
+////
+//// Public Functions:
+////
+
+NormalDiffPrinter::NormalDiffPrinter(bool printLines)
+{
+    m_printLines = printLines;
+    m_deletion.tokens = 0;
+    m_changes = 0;
+}
+
+// Public Function: operator()
+// Input: hunk - The next hunk of the edit script.
+// Output: None.
+void NormalDiffPrinter::operator()(const FileHunk &hunk)
+{
+    if (hunk.operation != KEEP_ELEMENTS)
+    {
+        m_changes += hunk.tokens;
+    }
+
+    if (hunk.operation == DELETE_ELEMENTS)
+    {
+        m_deletion = hunk;
+        return;
+    }
+
+    if (hunk.operation == KEEP_ELEMENTS)
+    {
+        flush();
+        return;
+    }
+
+    // An insertion, which changes the lines deleted just before it, if any:
+    if (m_deletion.tokens > 0)
+    {
+        printRange(m_deletion.token1 + 1, m_deletion.tokens);
+        printf("c");
+        printRange(hunk.token2 + 1, hunk.tokens);
+        printf("\n");
+        printLines('<', m_deletion.bytes1, m_deletion.length1);
+        printf("---\n");
+        m_deletion.tokens = 0;
+    }
+    else
+    {
+        printRange(hunk.token1, 1);
+        printf("a");
+        printRange(hunk.token2 + 1, hunk.tokens);
+        printf("\n");
+    }
+
+    printLines('>', hunk.bytes2, hunk.length2);
+}
+
+// Public Function: flush
+// Input: None.
+// Output: None.
+// Prints the deletion held back, if any.
+void NormalDiffPrinter::flush()
+{
+    if (m_deletion.tokens == 0)
+    {
+        return;
+    }
+
+    printRange(m_deletion.token1 + 1, m_deletion.tokens);
+    printf("d");
+    printRange(m_deletion.token2, 1);
+    printf("\n");
+    printLines('<', m_deletion.bytes1, m_deletion.length1);
+    m_deletion.tokens = 0;
+}
+
+// Public Function: changes
+// Input: None.
+// Output: The number of lines or records deleted or inserted so far.
+size_t NormalDiffPrinter::changes() const
+{
+    return m_changes;
+}
+
+
+////
+//// Private functions:
+////
+
+// Private Function: printRange
+// Input: first - The number, from 1, of the first line of a range.
+//        count - The number of lines in it.
+// Output: None.
+void NormalDiffPrinter::printRange(size_t first, size_t count)
+{
+    if (count == 1)
+    {
+        printf("%zu", first);
+    }
+    else
+    {
+        printf("%zu,%zu", first, first + count - 1);
+    }
+}
+
+// Private Function: printLines
+// Input: marker - The character printed before each line.
+//        bytes, length - The lines.
+// Output: None.
+void NormalDiffPrinter::printLines(char marker, const char *bytes,
+                                   size_t length)
+{
+    if (!m_printLines)
+    {
+        return;
+    }
+
+    const char *end = bytes + length;
+
+    while (bytes < end)
+    {
+        const char *lineEnd = findTokenEnd(bytes, end, 0);
+
+        printf("%c ", marker);
+        fwrite(bytes, 1, lineEnd - bytes, stdout);
+
+        if (lineEnd[-1] != '\n')
+        {
+            printf("\n\\ No newline at end of file\n");
+        }
+
+        bytes = lineEnd;
+    }
+}
+
+
+// Driver code:
+int main(int argc, char *argv[])
+{
+    if (argc != 3 && argc != 4)
+    {
+        fprintf(stderr, "Usage: %s file1 file2 [recordSize]\n", argv[0]);
+        return 2;
+    }
+
+    size_t recordSize = argc == 4 ? strtoul(argv[3], NULL, 10) : 0;
+    NormalDiffPrinter printer(recordSize == 0);
+    MappedFile file1, file2;
+
+    if (!file1.open(argv[1]) || !file2.open(argv[2]))
+    {
+        perror("FileDiff");
+        return 2;
+    }
+
+    // diffMappedFiles copies the printer it is given, so it is given a lambda
+    // that refers to this one. The deletion the printer may still hold back
+    // at the end points into the files, which are still mapped:
+    diffMappedFiles(file1, file2,
+                    [&](const FileHunk &hunk)
+                    {
+                        printer(hunk);
+                    },
+                    recordSize);
+    printer.flush();
+    fprintf(stderr, "%zu %s changed\n", printer.changes(),
+            recordSize == 0 ? "lines" : "records");
+
+    // Like diff, exit with 1 if the files differ:
+    return printer.changes() > 0 ? 1 : 0;
+}
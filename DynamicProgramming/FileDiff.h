@@ -0,0 +1,544 @@
+/* File: FileDiff.h
+ *
+ * This file contains diffFiles and diffMappedFiles, which find the edit
+ * script of EditScript.h between two files too large to be read into
+ * vectors, as lists of lines or of fixed-size records. The tokens the script
+ * keeps form a longest common subsequence of the two files.
+ *
+ * Both files are mapped into memory read-only, so their bytes are read from
+ * disk only as they are needed and stay in the page cache, which the system
+ * can reclaim, rather than in memory of our own. Then:
+ *
+ *  - The longest common prefix and suffix of the two files are found by
+ *    comparing their bytes directly, and shortened to whole tokens. They are
+ *    never split into tokens, so two versions of a large file that differ in
+ *    a few places cost little more than one pass of memcmp.
+ *  - The rest of each file is split into tokens in one pass, and each token
+ *    is kept as a 64-bit hash of its bytes together with where they are.
+ *  - The edit script of the two lists of tokens is found by findEditScript.
+ *    Tokens are compared by their hashes, and tokens with equal hashes are
+ *    also compared byte by byte, so a collision of hashes can never make
+ *    different tokens look the same.
+ *
+ * Besides the page cache, the memory used is 24 bytes for each token outside
+ * the common prefix and suffix, plus what findEditScript uses.
+ *
+ * The functions use the POSIX calls open, fstat and mmap. Compile with
+ * -std=c++11.
+ */
+
+#ifndef FILE_DIFF_H
+#define FILE_DIFF_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include "EditScript.h"
+
+using namespace std;
+
+// Data Structure: FileHunk
+// A run of tokens with the same operation, as in EditHunk. token1 and token2
+// are the positions, counted from 0, where the run starts in each file, and
+// tokens is its length. bytes1 and bytes2 point to the run in each file, and
+// length1 and length2 are its lengths in bytes there: a deletion has no bytes
+// in the second file and an insertion none in the first. The pointers point
+// into the mapped files.
+struct FileHunk
+{
+    EditOperation operation;
+    size_t token1;
+    size_t token2;
+    size_t tokens;
+    const char *bytes1;
+    size_t length1;
+    const char *bytes2;
+    size_t length2;
+};
+
+// Data Structure: FileToken
+// A line or record of a mapped file.
+struct FileToken
+{
+    uint64_t hash;
+    const char *bytes;
+    size_t length;
+};
+
+// Data Structure: MappedFile
+// A whole file mapped read-only into memory.
+class MappedFile
+{
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        bool open(const char *path);
+        const char *data() const;
+        size_t size() const;
+
+    private:
+        // Copying would unmap the same file twice:
+        MappedFile(const MappedFile &);
+        MappedFile &operator=(const MappedFile &);
+
+        void *m_mapping; // NULL if nothing, or an empty file, is mapped.
+        size_t m_size;
+};
+
+// Data Structure: FileHunkWriter
+// Passes the hunks findEditScript finds for the tokens between the common
+// prefix and suffix on as FileHunks.
+template <class Callback>
+class FileHunkWriter
+{
+    public:
+        FileHunkWriter(Callback &callback, size_t prefixTokens,
+                       const vector<FileToken> &tokens1, const char *end1,
+                       const vector<FileToken> &tokens2, const char *end2);
+
+        void operator()(const EditHunk &hunk);
+
+    private:
+        static const char *findBytes(const vector<FileToken> &tokens,
+                                     const char *end, size_t position);
+
+        Callback &m_callback;
+        size_t m_prefixTokens;
+        const vector<FileToken> &m_tokens1;
+        const char *m_end1; // Where the common suffix starts.
+        const vector<FileToken> &m_tokens2;
+        const char *m_end2;
+};
+
+
+////
+//// Public Functions:
+////
+
+inline MappedFile::MappedFile()
+{
+    m_mapping = NULL;
+    m_size = 0;
+}
+
+inline MappedFile::~MappedFile()
+{
+    if (m_mapping != NULL)
+    {
+        munmap(m_mapping, m_size);
+    }
+}
+
+// Public Function: open
+// Input: path - The file to map. Nothing may be mapped yet.
+// Output: Returns true if the whole file is now mapped.
+inline bool MappedFile::open(const char *path)
+{
+    int file = ::open(path, O_RDONLY);
+
+    if (file < 0)
+    {
+        return false;
+    }
+
+    struct stat status;
+
+    if (fstat(file, &status) != 0)
+    {
+        close(file);
+        return false;
+    }
+
+    // mmap cannot map an empty file:
+    if (status.st_size == 0)
+    {
+        close(file);
+        return true;
+    }
+
+    size_t fileSize = status.st_size;
+    void *mapping = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, file, 0);
+
+    // The mapping keeps the file open by itself:
+    close(file);
+
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_size = fileSize;
+
+    return true;
+}
+
+// Public Function: data
+// Input: None.
+// Output: The first byte of the file.
+inline const char *MappedFile::data() const
+{
+    return m_mapping == NULL ? "" : static_cast<const char *>(m_mapping);
+}
+
+// Public Function: size
+// Input: None.
+// Output: The size of the file in bytes.
+inline size_t MappedFile::size() const
+{
+    return m_size;
+}
+
+template <class Callback>
+FileHunkWriter<Callback>::FileHunkWriter(Callback &callback,
+                                         size_t prefixTokens,
+                                         const vector<FileToken> &tokens1,
+                                         const char *end1,
+                                         const vector<FileToken> &tokens2,
+                                         const char *end2)
+    : m_callback(callback), m_prefixTokens(prefixTokens),
+      m_tokens1(tokens1), m_end1(end1), m_tokens2(tokens2), m_end2(end2)
+{
+}
+
+// Public Function: operator()
+// Input: hunk - A hunk of the edit script of the tokens between the common
+//               prefix and suffix.
+// Output: None.
+template <class Callback>
+void FileHunkWriter<Callback>::operator()(const EditHunk &hunk)
+{
+    FileHunk fileHunk;
+    size_t tokens1 = hunk.operation == INSERT_ELEMENTS ? 0 : hunk.length;
+    size_t tokens2 = hunk.operation == DELETE_ELEMENTS ? 0 : hunk.length;
+
+    fileHunk.operation = hunk.operation;
+    fileHunk.token1 = m_prefixTokens + hunk.position1;
+    fileHunk.token2 = m_prefixTokens + hunk.position2;
+    fileHunk.tokens = hunk.length;
+    fileHunk.bytes1 = findBytes(m_tokens1, m_end1, hunk.position1);
+    fileHunk.length1 = findBytes(m_tokens1, m_end1, hunk.position1 + tokens1) -
+                       fileHunk.bytes1;
+    fileHunk.bytes2 = findBytes(m_tokens2, m_end2, hunk.position2);
+    fileHunk.length2 = findBytes(m_tokens2, m_end2, hunk.position2 + tokens2) -
+                       fileHunk.bytes2;
+
+    m_callback(static_cast<const FileHunk &>(fileHunk));
+}
+
+
+////
+//// Private functions:
+////
+
+// Private Function: findBytes
+// Input: tokens - The tokens of a file between the common prefix and suffix.
+//        end - Where the common suffix starts in the file.
+//        position - A position in tokens, or tokens.size().
+// Output: Where the token at position starts in the file.
+template <class Callback>
+const char *FileHunkWriter<Callback>::findBytes(
+    const vector<FileToken> &tokens, const char *end, size_t position)
+{
+    return position < tokens.size() ? tokens[position].bytes : end;
+}
+
+
+// Function operator==
+//
+// Inputs: token1, token2 - Two tokens.
+//
+// Output: Returns true if the tokens have the same bytes.
+inline bool operator==(const FileToken &token1, const FileToken &token2)
+{
+    return token1.hash == token2.hash && token1.length == token2.length &&
+           memcmp(token1.bytes, token2.bytes, token1.length) == 0;
+}
+
+// Function hashFileToken
+//
+// Inputs: bytes, length - The bytes of a token.
+//
+// Output: A 64-bit hash of the bytes.
+//
+// FNV-1a applied to whole 64-bit words instead of single bytes, with a shift
+// mixing the high bits back down, as in FrozenBinarySearchTree's checksum.
+inline uint64_t hashFileToken(const char *bytes, size_t length)
+{
+    const uint64_t PRIME = 0x100000001b3ULL;
+    uint64_t hash = 0xcbf29ce484222325ULL ^ length;
+    size_t i = 0;
+
+    for (; i + 8 <= length; i += 8)
+    {
+        uint64_t word;
+
+        memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * PRIME;
+        hash ^= hash >> 32;
+    }
+
+    for (; i < length; ++i)
+    {
+        hash = (hash ^ static_cast<unsigned char>(bytes[i])) * PRIME;
+    }
+
+    return hash;
+}
+
+// Function findTokenEnd
+//
+// Inputs: bytes, end - The bytes from the start of a token to the end of
+//                      those being split into tokens.
+//         recordSize - The size of a record, or 0 if the tokens are lines.
+//
+// Output: Where the token ends. A line ends after its newline, or at end if
+//         it has none, and the last record may be short.
+inline const char *findTokenEnd(const char *bytes, const char *end,
+                                size_t recordSize)
+{
+    if (recordSize > 0)
+    {
+        return static_cast<size_t>(end - bytes) > recordSize ?
+               bytes + recordSize : end;
+    }
+
+    const void *newline = memchr(bytes, '\n', end - bytes);
+
+    return newline == NULL ? end : static_cast<const char *>(newline) + 1;
+}
+
+// Function isTokenStart
+//
+// Inputs: data - The bytes of a file.
+//         position - A position in the file.
+//         begin - A position that starts a token, at or before position.
+//         recordSize - The size of a record, or 0 if the tokens are lines.
+//
+// Output: Returns true if a token starts at position.
+inline bool isTokenStart(const char *data, size_t position, size_t begin,
+                         size_t recordSize)
+{
+    if (recordSize > 0)
+    {
+        return position % recordSize == 0;
+    }
+
+    return position == begin || data[position - 1] == '\n';
+}
+
+// Function countTokens
+//
+// Inputs: bytes, length - Whole tokens.
+//         recordSize - The size of a record, or 0 if the tokens are lines.
+//
+// Output: Returns the number of tokens.
+inline size_t countTokens(const char *bytes, size_t length, size_t recordSize)
+{
+    if (recordSize > 0)
+    {
+        return (length + recordSize - 1) / recordSize;
+    }
+
+    size_t tokens = 0;
+    const char *end = bytes + length;
+
+    while (bytes < end)
+    {
+        bytes = findTokenEnd(bytes, end, 0);
+        ++tokens;
+    }
+
+    return tokens;
+}
+
+// Function splitIntoTokens
+//
+// Inputs: bytes, end - Whole tokens.
+//         recordSize - The size of a record, or 0 if the tokens are lines.
+//         tokens - Filled with the tokens.
+//
+// Output: None.
+//
+// The tokens are counted first, which takes a fraction of the time splitting
+// them does, so that tokens needs no more memory than they take.
+inline void splitIntoTokens(const char *bytes, const char *end,
+                            size_t recordSize, vector<FileToken> &tokens)
+{
+    tokens.clear();
+    tokens.reserve(countTokens(bytes, end - bytes, recordSize));
+
+    while (bytes < end)
+    {
+        FileToken token;
+        const char *tokenEnd = findTokenEnd(bytes, end, recordSize);
+
+        token.bytes = bytes;
+        token.length = tokenEnd - bytes;
+        token.hash = hashFileToken(bytes, token.length);
+        tokens.push_back(token);
+        bytes = tokenEnd;
+    }
+}
+
+// Function countMatchingBytes
+//
+// Inputs: bytes1, bytes2 - Two arrays of bytes.
+//         length - The number of bytes to compare.
+//         backward - Whether to compare the bytes before bytes1 and bytes2,
+//                    from the last to the first, instead of those after.
+//
+// Output: Returns the number of bytes that match before the first that
+//         differs.
+//
+// Most of the bytes are compared a block at a time with memcmp.
+inline size_t countMatchingBytes(const char *bytes1, const char *bytes2,
+                                 size_t length, bool backward)
+{
+    const size_t BLOCK_SIZE = 4096;
+    size_t matching = 0;
+
+    while (matching < length)
+    {
+        size_t block = min(BLOCK_SIZE, length - matching);
+        size_t offset = backward ? matching + block : matching;
+        const char *block1 = backward ? bytes1 - offset : bytes1 + offset;
+        const char *block2 = backward ? bytes2 - offset : bytes2 + offset;
+
+        if (memcmp(block1, block2, block) == 0)
+        {
+            matching += block;
+            continue;
+        }
+
+        for (size_t i = 0; i < block; ++i)
+        {
+            size_t at = backward ? block - 1 - i : i;
+
+            if (block1[at] != block2[at])
+            {
+                return matching + i;
+            }
+        }
+    }
+
+    return matching;
+}
+
+// Function diffMappedFiles
+//
+// Inputs: file1 - The file to be edited.
+//         file2 - The file it is to be turned into.
+//         callback - Called with each hunk of the edit script of the files'
+//                    tokens, as a const FileHunk &, in order from the start
+//                    of the files.
+//         recordSize - The size in bytes of the records the files are split
+//                      into, or 0 to split them into lines.
+//
+// Output: None.
+//
+// A line includes its newline, so a last line without one differs from the
+// same line with one. The hunks are grouped as those of findEditScript are.
+// See the description at the top of the file.
+template <class Callback>
+void diffMappedFiles(const MappedFile &file1, const MappedFile &file2,
+                     Callback callback, size_t recordSize = 0)
+{
+    const char *data1 = file1.data(), *data2 = file2.data();
+    size_t size1 = file1.size(), size2 = file2.size();
+
+    // The common prefix ends where the token that differs starts, or at the
+    // end of both files if they are the same:
+    size_t begin = countMatchingBytes(data1, data2, min(size1, size2), false);
+
+    if (begin < size1 || begin < size2)
+    {
+        while (!isTokenStart(data1, begin, 0, recordSize))
+        {
+            --begin;
+        }
+    }
+
+    // The common suffix must start a token in both files, and not overlap
+    // the prefix. The ends of the files always end a token:
+    size_t suffix = countMatchingBytes(data1 + size1, data2 + size2,
+                                       min(size1, size2) - begin, true);
+
+    while (suffix > 0 &&
+           (!isTokenStart(data1, size1 - suffix, begin, recordSize) ||
+            !isTokenStart(data2, size2 - suffix, begin, recordSize)))
+    {
+        --suffix;
+    }
+
+    size_t prefixTokens = countTokens(data1, begin, recordSize);
+    vector<FileToken> tokens1, tokens2;
+
+    splitIntoTokens(data1 + begin, data1 + size1 - suffix, recordSize,
+                    tokens1);
+    splitIntoTokens(data2 + begin, data2 + size2 - suffix, recordSize,
+                    tokens2);
+
+    if (begin > 0)
+    {
+        FileHunk prefix = {KEEP_ELEMENTS, 0, 0, prefixTokens,
+                           data1, begin, data2, begin};
+
+        callback(static_cast<const FileHunk &>(prefix));
+    }
+
+    findEditScript(tokens1, tokens2,
+                   FileHunkWriter<Callback>(callback, prefixTokens,
+                                            tokens1, data1 + size1 - suffix,
+                                            tokens2, data2 + size2 - suffix));
+
+    if (suffix > 0)
+    {
+        FileHunk common = {KEEP_ELEMENTS,
+                           prefixTokens + tokens1.size(),
+                           prefixTokens + tokens2.size(),
+                           countTokens(data1 + size1 - suffix, suffix,
+                                       recordSize),
+                           data1 + size1 - suffix, suffix,
+                           data2 + size2 - suffix, suffix};
+
+        callback(static_cast<const FileHunk &>(common));
+    }
+}
+
+// Function diffFiles
+//
+// Inputs: path1 - The file to be edited.
+//         path2 - The file it is to be turned into.
+//         callback - Called with each hunk of the edit script, as for
+//                    diffMappedFiles. The bytes of the hunks stay valid only
+//                    until diffFiles returns.
+//         recordSize - The size in bytes of the records the files are split
+//                      into, or 0 to split them into lines.
+//
+// Output: Returns false if either file could not be mapped, in which case
+//         the callback is not called.
+template <class Callback>
+bool diffFiles(const char *path1, const char *path2, Callback callback,
+               size_t recordSize = 0)
+{
+    MappedFile file1, file2;
+
+    if (!file1.open(path1) || !file2.open(path2))
+    {
+        return false;
+    }
+
+    diffMappedFiles(file1, file2, callback, recordSize);
+
+    return true;
+}
+
+#endif // FILE_DIFF_H
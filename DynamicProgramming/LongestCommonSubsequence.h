@@ -0,0 +1,497 @@
+/* File: LongestCommonSubsequence.h
+ *
+ * This file contains algorithms for finding the longest common subsequence
+ * of two vectors containing the same type of objects. A subsequence of a
+ * vector of objects of the same type is a new vector containing some of the
+ * objects in the original vector, all in the same order as the original
+ * vector. The same order meaning if A and B are two objects in the original
+ * vector, and indexA and indexB are the indices where A and B are located in
+ * the original object, then newIndexA and newIndexB be will satisfy the same
+ * inequality as indexA and indexB do (e.g. if indexA < indexB then newIndexA <
+ * newIndexB), where newIndexA and newIndexB are the indices where A and B are
+ * located in the new vector.
+ *
+ * The first algorithm uses recursion and memoization to take advantage of
+ * subproblem overlap and optimal substructure. It stores a copy of a whole
+ * subsequence for every pair of indices it visits, so it is only suitable for
+ * short sequences.
+ *
+ * The second algorithm is iterative and needs memory proportional to the
+ * length of the shorter sequence only. The length of the longest common
+ * subsequence is computed one row of the dynamic programming table at a time,
+ * keeping two rows, and the subsequence itself is recovered with Hirschberg's
+ * divide-and-conquer, which splits the table in two at its middle row and
+ * solves both halves in the same way. It takes O(n*m) time and can be used on
+ * sequences with hundreds of thousands of elements.
+ *
+ * Template functions are used so that the algorithms work for any types that
+ * have a constructor, a copier, a check for equality, and printing of the type
+ * to stdout.
+ *
+ * Compile with -std=c++11.
+ */
+
+#ifndef LONGEST_COMMON_SUBSEQUENCE_H
+#define LONGEST_COMMON_SUBSEQUENCE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+
+// Function mapTwoIntegersToOneInteger
+//
+// Inputs: num1 - One of the numbers to be combined into a single number.
+//         num2 - The other number to be combined into a single number.
+// 
+// Output: Returns Szudzik's function of num1 and num2. This provides a unique
+//         integer which is within the bounds of twice the size of the maximum
+//         value between num1 and num2. I.e. if num1 and num2 are less than or
+//         equal to the maximum 32-bit integer than this function will return a
+//         number less than or equal to the maximum 64-bit integer. 
+//
+// This function is useful for turning two integers into a unique integer to be
+// used as the key for a map.
+inline int mapTwoIntegersToOneInteger(int num1, int num2)
+{
+    return (num1 >= num2 ? num1*num1 + num1 + num2 : num1 + num2*num2);
+}
+
+// Function findLongestCommonSubsequence
+//
+// Inputs: sequence1 - The first of two sequences used in searching for the
+//                     longest common subsequence between them.
+//         currentIndex1 - The index of the element of sequence1 that will be
+//                         compared against sequence2.
+//         sequence2 - The second of two sequences used in searching for the
+//                     longest common subsequence between them.
+//         currentIndex2 - The index of the element of sequence2 that will be
+//                         compared against sequence1.
+//         currentCommonSubsequence
+//             - The longest common subsequence of sequence1 and sequence2 that
+//               has been found so far.
+//         memoizer - A map whose keys are integers formed from combining the
+//                    two current indices of both sequences, and whose values
+//                    are the longest common subsequence starting at those
+//                    indices. 
+//
+// Output: A vector containing the longest common subsequence of the two input
+//          sequences.
+//
+// This function uses a recursive algorithm with memoization. We compare the
+// elements at the current indices, and if they are equal then we append them
+// to the longest common subsequence and recursively call the function at the
+// next higher indices. If they are not equal then we have to find the two
+// remaining possible subsequence extensions by:
+// (1) Incrementing currentIndex1 and leaving currentIndex2 unchanged, or
+// (2) Leaving currentIndex1 unchanged and incrementing currentIndex2,
+// The longest common subsequence is then the longest out of these two options.
+//
+// The case of incrementing both indices will occur inside the recursive calls
+// of both (1) and (2), leading to double checking the same solution, hence
+// this algorithm is improved by storing solutions as we compute them and
+// looking for an already computed solution before we compute one.
+//
+// If multiple longest common subsequences with the same length are found we
+// return only the one that was found first.
+//
+// A template argument, T, is used. The requirements for a type to be used are:
+// (a) The type has a constructor,
+// (b) Two instances of the type can be checked for equality,
+// (c) The type has a function for copying into another instance of the same
+// type (used in the vector push_back() call).
+template <class T>
+vector<T> findLongestCommonSubsequence(vector<T> &sequence1, int currentIndex1,
+                                       vector<T> &sequence2, int currentIndex2,
+                                       vector<T> &currentCommonSubsequence,
+                                       unordered_map<int, vector<T> > &memoizer)
+{
+    // Makre sure the indices are within the bounds of the vectors:
+    if (currentIndex1 < 0 || currentIndex2 < 0 ||
+        currentIndex1 >= sequence1.size() || currentIndex2 >= sequence2.size())
+    {
+        return currentCommonSubsequence;
+    }
+
+    // If the elements at the current indices are equal then we can extend the
+    // longest known sequence by this element:
+    if (sequence1[currentIndex1] == sequence2[currentIndex2])
+    {
+        vector<T> newCommonSubsequence, resultCommonSubsequence;
+        int key = mapTwoIntegersToOneInteger(currentIndex1+1, currentIndex2+1);
+        auto got = memoizer.find(key);
+
+        newCommonSubsequence.push_back(sequence1[currentIndex1]);
+
+        // Check if the longest common subsequence starting at indices
+        // (currentIndex1 + 1) and (currentIndex2 + 1) has already been found:
+        if (got != memoizer.end())
+        {
+            // Prepend the current element to the known longest common sequence
+            // starting at (currentIndex1+1) and (currentIndex2+1):
+            newCommonSubsequence.insert(newCommonSubsequence.end(),
+                                        got->second.begin(), got->second.end());
+
+            // Store the longest common subsequence for indices currentIndex1
+            // and currentIndex2:
+            memoizer.emplace(key, newCommonSubsequence);
+
+            return newCommonSubsequence;
+        }
+        // If the solution wasn't already calculated then calculate and store
+        // it:
+        else
+        {
+            vector<T> temp = findLongestCommonSubsequence(sequence1,
+                                 currentIndex1+1, sequence2, currentIndex2+1,
+                                 newCommonSubsequence, memoizer);
+            memoizer.emplace(key, temp);
+            return temp;
+        }
+    }
+    // If the elements a the current indices are not equal then check the two
+    // ways we can extend the sequence:
+    else
+    {
+        vector<T> longestCandidate1, longestCandidate2;
+        int key1 = mapTwoIntegersToOneInteger(currentIndex1+1, currentIndex2);
+        int key2 = mapTwoIntegersToOneInteger(currentIndex1, currentIndex2+1);
+        auto got1 = memoizer.find(key1);
+        auto got2 = memoizer.find(key2);
+
+        // Check if the longest common subsequence starting at indices
+        // (currentIndex1 + 1) and currentIndex2 has already been found:
+        if (got1 != memoizer.end())
+        {
+            longestCandidate1 = got1->second;
+        }
+        // If not then calculate and store it:
+        else
+        {
+            longestCandidate1 = findLongestCommonSubsequence(sequence1,
+                                    currentIndex1+1, sequence2, currentIndex2,
+                                    currentCommonSubsequence, memoizer);
+
+            memoizer.emplace(key1, longestCandidate1);
+        }
+
+        // Check if the longest common subsequence starting at indices
+        // currentIndex1 and (currentIndex2 + 1) has already been found:
+        if (got2 != memoizer.end())
+        {
+            longestCandidate2 = got2->second;
+        }
+        // If not then calculate and store it:
+        else
+        {
+            longestCandidate2 = findLongestCommonSubsequence(sequence1,
+                                    currentIndex1, sequence2, currentIndex2+1,
+                                    currentCommonSubsequence, memoizer);
+
+            memoizer.emplace(key2, longestCandidate2);
+        }
+
+        // Now compare the sizes of the candidates and return the larger one:
+        int size1 = longestCandidate1.size(), size2 = longestCandidate2.size();
+
+        if (size1 >= size2)
+        {
+            return longestCandidate1;
+        }
+        else
+        {
+            return longestCandidate2;
+        }
+    }
+}
+
+// Data Structure: LinearSubsequenceSearch
+// What findLongestCommonSubsequence(sequence1, sequence2) shares between the
+// calls of appendLongestCommonSubsequence. The dynamic programming table has
+// one row per element of rows and one column per element of columns. Rows is
+// the longer of the two sequences, so that a table row, and with it every
+// buffer below, is as short as possible.
+template <class T>
+struct LinearSubsequenceSearch
+{
+    const vector<T> *rows;
+    const vector<T> *columns;
+
+    // lengths[c] is the length of the longest common subsequence of the rest
+    // of the rows from the current row on and the rest of the columns from
+    // column c on. below holds the same for the row below. crossings and
+    // crossingsBelow hold, for the same cells, the column at which the path
+    // of the subsequence chosen from that cell reaches the middle row.
+    vector<size_t> lengths;
+    vector<size_t> below;
+    vector<size_t> crossings;
+    vector<size_t> crossingsBelow;
+
+    vector<T> *subsequence;
+};
+
+// Function elementsAreEqual
+//
+// Inputs: rowElement - An element of the rows of a table.
+//         columnElement - An element of its columns.
+//
+// Output: Returns true if the two elements are equal. The element of
+//         sequence1 is always on the left of the ==, as in the recursive
+//         findLongestCommonSubsequence.
+//
+// The template argument RowsAreSequence1 tells which of the two elements
+// belongs to sequence1.
+template <bool RowsAreSequence1, class T>
+inline bool elementsAreEqual(const T &rowElement, const T &columnElement)
+{
+    return RowsAreSequence1 ? rowElement == columnElement :
+                              columnElement == rowElement;
+}
+
+// Function appendLongestCommonSubsequence
+//
+// Inputs: search - The sequences, the buffers and the subsequence found so
+//                  far.
+//         rowBegin, rowEnd - The rows [rowBegin, rowEnd) of the part of the
+//                            table to be solved.
+//         columnBegin, columnEnd - The columns [columnBegin, columnEnd) of the
+//                                  part of the table to be solved.
+//
+// Output: None. The longest common subsequence of the rows and columns given
+//         is appended to search.subsequence.
+//
+// The subsequence is the one the recursive findLongestCommonSubsequence
+// describes: walking from the first row and column, equal elements are always
+// taken, and otherwise the walk skips the element of sequence1 unless that
+// would give a shorter subsequence than skipping the element of sequence2.
+// The walk in a part of the table between two cells on it is the same walk
+// as the one that part of the table would give by itself, so the part is
+// solved by finding the cell where the walk reaches the middle row, and then
+// solving the parts above and below that cell.
+//
+// That cell is found in a single pass from the last row up to the first. The
+// pass computes the lengths of the longest common subsequences from every
+// cell on, and from the middle row up it also records, for each cell, where
+// the walk starting there reaches the middle row: the walk takes one step to
+// the cell below, to its right or diagonally, and it reaches the middle row
+// where the walk from that cell does.
+//
+// Every pass reads the whole part of the table it solves, and the two parts
+// left together have at most half its cells, so all passes together read at
+// most twice as many cells as the table has.
+//
+// The template argument RowsAreSequence1 tells whether the rows are the
+// elements of sequence1 or of sequence2.
+template <bool RowsAreSequence1, class T>
+void appendLongestCommonSubsequence(LinearSubsequenceSearch<T> &search,
+                                    size_t rowBegin, size_t rowEnd,
+                                    size_t columnBegin, size_t columnEnd)
+{
+    if (rowBegin == rowEnd || columnBegin == columnEnd)
+    {
+        return;
+    }
+
+    const T *rows = search.rows->data();
+    const T *columns = search.columns->data() + columnBegin;
+    size_t width = columnEnd - columnBegin;
+
+    // With one row left the walk takes the first element equal to it, since
+    // skipping it first could only lose it:
+    if (rowEnd - rowBegin == 1)
+    {
+        for (size_t column = 0; column < width; ++column)
+        {
+            if (elementsAreEqual<RowsAreSequence1>(rows[rowBegin],
+                                                   columns[column]))
+            {
+                search.subsequence->push_back(RowsAreSequence1 ?
+                                              rows[rowBegin] :
+                                              columns[column]);
+                break;
+            }
+        }
+
+        return;
+    }
+
+    size_t middleRow = rowBegin + (rowEnd - rowBegin) / 2;
+    size_t *lengths = search.lengths.data();
+    size_t *below = search.below.data();
+    size_t *crossings = search.crossings.data();
+    size_t *crossingsBelow = search.crossingsBelow.data();
+
+    // Past the last row and column the lengths are all zero:
+    fill(below, below + width + 1, 0);
+    lengths[width] = 0;
+
+    for (size_t row = rowEnd; row-- > middleRow; )
+    {
+        for (size_t column = width; column-- > 0; )
+        {
+            // Equal elements give a subsequence at least as long as the
+            // other two ways, and unequal ones one that is not longer, so
+            // the maximum of the three needs no branch:
+            size_t equal = elementsAreEqual<RowsAreSequence1>(rows[row],
+                                                              columns[column]);
+
+            lengths[column] = max(max(below[column], lengths[column + 1]),
+                                  below[column + 1] + equal);
+        }
+
+        swap(lengths, below);
+    }
+
+    // A walk from the middle row is already there:
+    for (size_t column = 0; column <= width; ++column)
+    {
+        crossingsBelow[column] = column;
+    }
+
+    crossings[width] = width;
+
+    for (size_t row = middleRow; row-- > rowBegin; )
+    {
+        for (size_t column = width; column-- > 0; )
+        {
+            // Whether elements are equal, and which way is longer, is as
+            // good as random, so the crossing is chosen with masks rather
+            // than with branches the processor would mispredict:
+            size_t equal = elementsAreEqual<RowsAreSequence1>(rows[row],
+                                                              columns[column]);
+            size_t down = below[column], right = lengths[column + 1];
+            size_t skipRow = RowsAreSequence1 ? down >= right : down > right;
+            size_t diagonalMask = 0 - equal, downMask = 0 - skipRow;
+            size_t skipCrossing = (crossingsBelow[column] & downMask) |
+                                  (crossings[column + 1] & ~downMask);
+
+            lengths[column] = max(max(down, right), below[column + 1] + equal);
+            crossings[column] = (crossingsBelow[column + 1] & diagonalMask) |
+                                (skipCrossing & ~diagonalMask);
+        }
+
+        swap(lengths, below);
+        swap(crossings, crossingsBelow);
+    }
+
+    size_t middleColumn = columnBegin + crossingsBelow[0];
+
+    appendLongestCommonSubsequence<RowsAreSequence1>(search,
+        rowBegin, middleRow, columnBegin, middleColumn);
+    appendLongestCommonSubsequence<RowsAreSequence1>(search,
+        middleRow, rowEnd, middleColumn, columnEnd);
+}
+
+// Function findLongestCommonSubsequence
+//
+// Inputs: sequence1 - The first of two sequences used in searching for the
+//                     longest common subsequence between them.
+//         sequence2 - The second of two sequences used in searching for the
+//                     longest common subsequence between them.
+//
+// Output: A vector containing the longest common subsequence of the two input
+//          sequences.
+//
+// This function gives the same subsequence as the recursive version: if
+// several longest common subsequences exist, the one returned is the one the
+// recursion prefers, which skips an element of sequence1 rather than one of
+// sequence2 whenever both lead to equally long subsequences. It needs
+// O(min(n, m)) memory besides the result and O(n*m) time, where n and m are
+// the lengths of the sequences. See appendLongestCommonSubsequence.
+//
+// The template argument, T, has the same requirements as for the recursive
+// version.
+template <class T>
+vector<T> findLongestCommonSubsequence(const vector<T> &sequence1,
+                                       const vector<T> &sequence2)
+{
+    LinearSubsequenceSearch<T> search;
+    vector<T> subsequence;
+
+    bool rowsAreSequence1 = sequence1.size() >= sequence2.size();
+
+    search.rows = rowsAreSequence1 ? &sequence1 : &sequence2;
+    search.columns = rowsAreSequence1 ? &sequence2 : &sequence1;
+    search.lengths.resize(search.columns->size() + 1);
+    search.below.resize(search.columns->size() + 1);
+    search.crossings.resize(search.columns->size() + 1);
+    search.crossingsBelow.resize(search.columns->size() + 1);
+    search.subsequence = &subsequence;
+
+    if (rowsAreSequence1)
+    {
+        appendLongestCommonSubsequence<true>(search, 0, search.rows->size(),
+                                             0, search.columns->size());
+    }
+    else
+    {
+        appendLongestCommonSubsequence<false>(search, 0, search.rows->size(),
+                                              0, search.columns->size());
+    }
+
+    return subsequence;
+}
+
+// Function findLongestCommonSubsequenceLength
+//
+// Inputs: sequence1 - The first of two sequences.
+//         sequence2 - The second of two sequences.
+//
+// Output: Returns the length of the longest common subsequence of the two
+//         sequences.
+//
+// Only the length is computed, one row of the table at a time from the
+// previous one, so this is about twice as fast as finding the subsequence
+// itself and needs O(min(n, m)) memory.
+template <class T>
+size_t findLongestCommonSubsequenceLength(const vector<T> &sequence1,
+                                          const vector<T> &sequence2)
+{
+    bool rowsAreSequence1 = sequence1.size() >= sequence2.size();
+    const vector<T> &rows = rowsAreSequence1 ? sequence1 : sequence2;
+    const vector<T> &columns = rowsAreSequence1 ? sequence2 : sequence1;
+    vector<size_t> lengths(columns.size() + 1, 0);
+    vector<size_t> above(columns.size() + 1, 0);
+
+    // Here lengths[c] is the length of the longest common subsequence of the
+    // rows up to and including the current one and the first c columns:
+    for (size_t row = 0; row < rows.size(); ++row)
+    {
+        for (size_t column = 0; column < columns.size(); ++column)
+        {
+            // As in appendLongestCommonSubsequence, the maximum of the three
+            // ways needs no branch:
+            size_t equal = rowsAreSequence1 ? rows[row] == columns[column] :
+                                              columns[column] == rows[row];
+
+            lengths[column + 1] = max(max(above[column + 1], lengths[column]),
+                                      above[column] + equal);
+        }
+
+        swap(lengths, above);
+    }
+
+    return above[columns.size()];
+}
+
+// Function PrintSequence
+//
+// Input: sequence - A sequence of elements of arbitary type T.
+// Output: None.
+//
+// This function uses a template type, T, which must have a function for
+// printing to stdout.
+template<class T>
+void printSequence(vector<T> sequence)
+{
+    for (int i = 0; i < sequence.size(); ++i)
+    {
+        cout << sequence[i] << " ";
+    }
+}
+
+#endif // LONGEST_COMMON_SUBSEQUENCE_H
@@ -0,0 +1,173 @@
+/* File: LongestCommonSubsequenceSearch.cpp
+ *
+ * This file contains driver code for LongestCommonSubsequenceSearch: it finds
+ * the sequences of a corpus of DNA most similar to a query, and times the
+ * search against comparing the query with every sequence of the corpus by
+ * repeated calls of findLongestCommonSubsequenceLength and of
+ * findLongestCommonSubsequenceLengthBitParallel.
+ *
+ * Compile with -std=c++11 -O2 -pthread.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "LongestCommonSubsequenceSearch.h"
+
+using namespace std;
+
+// Function randomDna
+//
+// Inputs: size - The number of letters.
+//         generator - The source of randomness.
+//
+// Output: A random sequence of DNA.
+vector<char> randomDna(size_t size, mt19937 &generator)
+{
+    vector<char> dna(size);
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        dna[i] = "ACGT"[generator() % 4];
+    }
+
+    return dna;
+}
+
+// Function findMostSimilarOneByOne
+//
+// Inputs: query - The sequence the others are compared with.
+//         corpus - The sequences to compare with the query.
+//         count - The number of sequences to find.
+//         bitParallel - Whether to use findLongestCommonSubsequenceLength
+//                       or findLongestCommonSubsequenceLengthBitParallel.
+//
+// Output: The same as LongestCommonSubsequenceSearch::findMostSimilar.
+vector<SimilarSequence> findMostSimilarOneByOne(
+    const vector<char> &query, const vector<vector<char> > &corpus,
+    size_t count, bool bitParallel)
+{
+    vector<SimilarSequence> results;
+
+    for (size_t i = 0; i < corpus.size(); ++i)
+    {
+        SimilarSequence result;
+
+        result.index = i;
+        result.length = bitParallel ?
+            findLongestCommonSubsequenceLengthBitParallel(query, corpus[i]) :
+            findLongestCommonSubsequenceLength(query, corpus[i]);
+        results.push_back(result);
+    }
+
+    sort(results.begin(), results.end(),
+         [](const SimilarSequence &sequence1,
+            const SimilarSequence &sequence2)
+         {
+             return sequence1.length != sequence2.length ?
+                    sequence1.length > sequence2.length :
+                    sequence1.index < sequence2.index;
+         });
+    results.resize(min(count, results.size()));
+
+    return results;
+}
+
+// Function secondsSince
+//
+// Inputs: start - A time.
+//
+// Output: The seconds passed since then.
+double secondsSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() -
+                                    start).count();
+}
+
+
+// Driver code:
+int main()
+{
+    const size_t QUERY_SIZE = 1000;
+    const size_t CORPUS_SIZE = 2000;
+    const size_t RELATIVES = 40;
+    const size_t RESULTS = 10;
+
+    mt19937 generator(2024);
+    vector<char> query = randomDna(QUERY_SIZE, generator);
+    vector<vector<char> > corpus;
+
+    // Mostly unrelated sequences of 100 to 2000 letters, and a few copies of
+    // the query with some letters changed, which should be found:
+    for (size_t i = 0; i < CORPUS_SIZE; ++i)
+    {
+        if (i % (CORPUS_SIZE / RELATIVES) == 0)
+        {
+            vector<char> relative = query;
+
+            for (size_t j = 0; j < i / 10; ++j)
+            {
+                relative[generator() % relative.size()] =
+                    "ACGT"[generator() % 4];
+            }
+
+            corpus.push_back(relative);
+        }
+        else
+        {
+            corpus.push_back(randomDna(100 + generator() % 1901, generator));
+        }
+    }
+
+    ThreadPool pool;
+    size_t compared = 0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<SimilarSequence> dense =
+        findMostSimilarOneByOne(query, corpus, RESULTS, false);
+    double denseSeconds = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    vector<SimilarSequence> bitParallel =
+        findMostSimilarOneByOne(query, corpus, RESULTS, true);
+    double bitParallelSeconds = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    LongestCommonSubsequenceSearch<char> search(query);
+    vector<SimilarSequence> batch =
+        search.findMostSimilar(corpus, RESULTS, pool, &compared);
+    double batchSeconds = secondsSince(start);
+
+    printf("The %zu of %zu sequences most similar to a query of %zu "
+           "letters:\n", RESULTS, corpus.size(), query.size());
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        printf("  sequence %4zu, %zu letters in common\n", batch[i].index,
+               batch[i].length);
+    }
+
+    bool same = true;
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        same = same && batch[i].index == dense[i].index &&
+               batch[i].length == dense[i].length &&
+               batch[i].index == bitParallel[i].index &&
+               batch[i].length == bitParallel[i].length;
+    }
+
+    printf("findLongestCommonSubsequenceLength for each: %.3f s\n",
+           denseSeconds);
+    printf("findLongestCommonSubsequenceLengthBitParallel for each: "
+           "%.3f s\n", bitParallelSeconds);
+    printf("LongestCommonSubsequenceSearch, %zu thread(s): %.3f s, "
+           "%zu sequences compared, %zu skipped\n", pool.size(),
+           batchSeconds, compared, corpus.size() - compared);
+    printf("All three find %s sequences.\n",
+           same && batch.size() == dense.size() ? "the same" : "different");
+
+    return 0;
+}
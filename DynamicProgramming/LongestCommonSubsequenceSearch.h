@@ -0,0 +1,507 @@
+/* File: LongestCommonSubsequenceSearch.h
+ *
+ * This file contains the LongestCommonSubsequenceSearch class template, which
+ * compares one sequence, the query, with many others, and finds those of a
+ * corpus with the longest common subsequences with it.
+ *
+ * Everything that depends only on the query is done once, when the search is
+ * made. The symbols of the query are numbered from 1, and every sequence
+ * compared with it is rewritten with those numbers, symbols the query does
+ * not have becoming 0. The longest common subsequence is not changed by
+ * this, and a query of fewer than 256 different symbols becomes a sequence
+ * of bytes, whose match masks BitParallelLongestCommonSubsequence computes
+ * once and then compares with each sequence 64 or more cells of the table at
+ * a time. A query of more symbols is compared with
+ * findLongestCommonSubsequenceLength.
+ *
+ * findMostSimilar shares a corpus between the threads of a ThreadPool. Each
+ * thread keeps the best sequences it has found so far, and the lowest length
+ * among the best of any thread is a length the final results must reach. Two
+ * upper bounds on the length of the longest common subsequence of the query
+ * and a sequence let most sequences that cannot reach it be skipped:
+ *
+ *  - The length of the shorter of the two, known without reading the
+ *    sequence. The sequences are visited from the largest bound to the
+ *    smallest, so that the best are likely found early, and the search stops
+ *    at the first sequence whose bound is too small.
+ *  - The number of elements of each symbol the two have in common, summed
+ *    over the symbols, which is counted while the sequence is rewritten, for
+ *    little more than the cost of reading it.
+ *
+ * Compile with -std=c++11 -pthread.
+ */
+
+#ifndef LONGEST_COMMON_SUBSEQUENCE_SEARCH_H
+#define LONGEST_COMMON_SUBSEQUENCE_SEARCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "BitParallelLongestCommonSubsequence.h"
+#include "LongestCommonSubsequence.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Data Structure: SimilarSequence
+// A sequence of a corpus, and the length of its longest common subsequence
+// with the query.
+struct SimilarSequence
+{
+    size_t index; // The position of the sequence in the corpus.
+    size_t length;
+};
+
+// Data Structure: SymbolCodes
+// The numbers of the symbols of a query, from 1. Symbols of one byte are
+// looked up in an array, and others in a hash table.
+template <class T, class Hash,
+          bool IsByte = is_integral<T>::value && sizeof(T) == 1>
+class SymbolCodes
+{
+    public:
+        uint32_t add(const T &symbol);
+        uint32_t find(const T &symbol) const;
+        size_t size() const;
+
+    private:
+        unordered_map<T, uint32_t, Hash> m_codes;
+};
+
+template <class T, class Hash>
+class SymbolCodes<T, Hash, true>
+{
+    public:
+        SymbolCodes();
+
+        uint32_t add(const T &symbol);
+        uint32_t find(const T &symbol) const;
+        size_t size() const;
+
+    private:
+        uint32_t m_codes[256]; // 0 for symbols not added.
+        size_t m_size;
+};
+
+// Data Structure: LongestCommonSubsequenceSearch
+template <class T, class Hash = hash<T> >
+class LongestCommonSubsequenceSearch
+{
+    public:
+        explicit LongestCommonSubsequenceSearch(const vector<T> &query);
+
+        size_t querySize() const;
+        size_t length(const vector<T> &sequence) const;
+        vector<SimilarSequence> findMostSimilar(
+            const vector<vector<T> > &corpus, size_t count, ThreadPool &pool,
+            size_t *compared = NULL) const;
+
+    private:
+        // A sequence rewritten with the codes of the query's symbols, in
+        // bytes if the query has fewer than 256 symbols, and the number of
+        // elements with each code. One thread reuses it for every sequence.
+        struct EncodedSequence
+        {
+            vector<uint8_t> bytes;
+            vector<uint32_t> codes;
+            vector<size_t> counts;
+        };
+
+        // What the threads of findMostSimilar share:
+        struct CorpusSearch
+        {
+            const vector<vector<T> > *corpus;
+            size_t count;
+            vector<size_t> order; // Of decreasing min(query, sequence) size.
+            atomic<size_t> next;  // The next position in order to compare.
+            atomic<size_t> threshold; // A length the results must reach.
+            atomic<size_t> compared;
+            mutex lock;
+            vector<SimilarSequence> results; // The best of every thread.
+        };
+
+        static bool isMoreSimilar(const SimilarSequence &sequence1,
+                                  const SimilarSequence &sequence2);
+
+        size_t encode(const vector<T> &sequence,
+                      EncodedSequence &encoded) const;
+        size_t lengthOfEncoded(const EncodedSequence &encoded) const;
+        void searchCorpus(CorpusSearch &search) const;
+
+        size_t m_querySize;
+        SymbolCodes<T, Hash> m_codes;
+        vector<size_t> m_symbolCounts; // The number of each code in the query.
+        vector<uint32_t> m_queryCodes; // Used if m_bitParallel is NULL.
+        unique_ptr<BitParallelLongestCommonSubsequence<uint8_t> >
+            m_bitParallel;
+};
+
+
+////
+//// Public Functions:
+////
+
+// Public Function: add
+// Inputs: symbol - A symbol of the query.
+// Output: Its code, which is new if the symbol has not been added before.
+template <class T, class Hash, bool IsByte>
+uint32_t SymbolCodes<T, Hash, IsByte>::add(const T &symbol)
+{
+    uint32_t &code = m_codes[symbol];
+
+    if (code == 0)
+    {
+        code = static_cast<uint32_t>(m_codes.size());
+    }
+
+    return code;
+}
+
+// Public Function: find
+// Inputs: symbol - Any symbol.
+// Output: Its code, or 0 if it is not a symbol of the query.
+template <class T, class Hash, bool IsByte>
+uint32_t SymbolCodes<T, Hash, IsByte>::find(const T &symbol) const
+{
+    typename unordered_map<T, uint32_t, Hash>::const_iterator found =
+        m_codes.find(symbol);
+
+    return found == m_codes.end() ? 0 : found->second;
+}
+
+// Public Function: size
+// Inputs: None.
+// Output: The number of symbols added.
+template <class T, class Hash, bool IsByte>
+size_t SymbolCodes<T, Hash, IsByte>::size() const
+{
+    return m_codes.size();
+}
+
+template <class T, class Hash>
+SymbolCodes<T, Hash, true>::SymbolCodes()
+{
+    fill(m_codes, m_codes + 256, 0);
+    m_size = 0;
+}
+
+template <class T, class Hash>
+uint32_t SymbolCodes<T, Hash, true>::add(const T &symbol)
+{
+    uint32_t &code = m_codes[static_cast<uint8_t>(symbol)];
+
+    if (code == 0)
+    {
+        code = static_cast<uint32_t>(++m_size);
+    }
+
+    return code;
+}
+
+template <class T, class Hash>
+inline uint32_t SymbolCodes<T, Hash, true>::find(const T &symbol) const
+{
+    return m_codes[static_cast<uint8_t>(symbol)];
+}
+
+template <class T, class Hash>
+size_t SymbolCodes<T, Hash, true>::size() const
+{
+    return m_size;
+}
+
+// Public Function: LongestCommonSubsequenceSearch
+// Inputs: query - The sequence the others are compared with.
+// Output: None.
+template <class T, class Hash>
+LongestCommonSubsequenceSearch<T, Hash>::LongestCommonSubsequenceSearch(
+    const vector<T> &query)
+{
+    m_querySize = query.size();
+    m_queryCodes.reserve(query.size());
+
+    for (size_t i = 0; i < query.size(); ++i)
+    {
+        m_queryCodes.push_back(m_codes.add(query[i]));
+    }
+
+    m_symbolCounts.assign(m_codes.size() + 1, 0);
+
+    for (size_t i = 0; i < m_queryCodes.size(); ++i)
+    {
+        ++m_symbolCounts[m_queryCodes[i]];
+    }
+
+    if (m_codes.size() < 256)
+    {
+        vector<uint8_t> pattern(m_queryCodes.begin(), m_queryCodes.end());
+
+        m_bitParallel.reset(
+            new BitParallelLongestCommonSubsequence<uint8_t>(pattern));
+        vector<uint32_t>().swap(m_queryCodes);
+    }
+}
+
+// Public Function: querySize
+// Inputs: None.
+// Output: The length of the query.
+template <class T, class Hash>
+size_t LongestCommonSubsequenceSearch<T, Hash>::querySize() const
+{
+    return m_querySize;
+}
+
+// Public Function: length
+// Inputs: sequence - A sequence to compare with the query.
+// Output: Returns the length of the longest common subsequence of the query
+//          and the sequence.
+template <class T, class Hash>
+size_t LongestCommonSubsequenceSearch<T, Hash>::length(
+    const vector<T> &sequence) const
+{
+    EncodedSequence encoded;
+
+    encode(sequence, encoded);
+
+    return lengthOfEncoded(encoded);
+}
+
+// Public Function: findMostSimilar
+// Inputs: corpus - The sequences to compare with the query.
+//         count - The number of sequences to find.
+//         pool - The threads to use. The calling thread only waits.
+//         compared - If not NULL, set to the number of sequences that could
+//                    not be skipped and were compared with the query.
+// Output: The count sequences of the corpus with the longest common
+//          subsequences with the query, or all of them if there are fewer,
+//          from the longest to the shortest. Of sequences with the same
+//          length, those earlier in the corpus come first.
+// See the description at the top of the file.
+template <class T, class Hash>
+vector<SimilarSequence>
+LongestCommonSubsequenceSearch<T, Hash>::findMostSimilar(
+    const vector<vector<T> > &corpus, size_t count, ThreadPool &pool,
+    size_t *compared) const
+{
+    CorpusSearch search;
+    size_t query = m_querySize;
+
+    search.corpus = &corpus;
+    search.count = count;
+    search.next = 0;
+    search.threshold = 0;
+    search.compared = 0;
+
+    if (count > 0)
+    {
+        search.order.resize(corpus.size());
+
+        for (size_t i = 0; i < corpus.size(); ++i)
+        {
+            search.order[i] = i;
+        }
+
+        stable_sort(search.order.begin(), search.order.end(),
+                    [&](size_t index1, size_t index2)
+                    {
+                        return min(query, corpus[index1].size()) >
+                               min(query, corpus[index2].size());
+                    });
+
+        CorpusSearch *searchPointer = &search;
+
+        for (size_t i = 0; i < pool.size(); ++i)
+        {
+            pool.submit([this, searchPointer]()
+                        {
+                            searchCorpus(*searchPointer);
+                        });
+        }
+
+        pool.wait();
+    }
+
+    sort(search.results.begin(), search.results.end(), isMoreSimilar);
+
+    if (search.results.size() > count)
+    {
+        search.results.resize(count);
+    }
+
+    if (compared != NULL)
+    {
+        *compared = search.compared;
+    }
+
+    return search.results;
+}
+
+
+////
+//// Private functions:
+////
+
+// Private Function: isMoreSimilar
+// Inputs: sequence1, sequence2 - Two sequences of the corpus.
+// Output: True if sequence1 comes before sequence2 in the results.
+template <class T, class Hash>
+inline bool LongestCommonSubsequenceSearch<T, Hash>::isMoreSimilar(
+    const SimilarSequence &sequence1, const SimilarSequence &sequence2)
+{
+    return sequence1.length != sequence2.length ?
+           sequence1.length > sequence2.length :
+           sequence1.index < sequence2.index;
+}
+
+// Private Function: encode
+// Inputs: sequence - A sequence to compare with the query.
+//         encoded - Set to the sequence rewritten with the codes of the
+//                   query's symbols.
+// Output: Returns the number of elements of each symbol the sequence and the
+//          query have in common, summed over the symbols, which bounds the
+//          length of their longest common subsequence.
+template <class T, class Hash>
+size_t LongestCommonSubsequenceSearch<T, Hash>::encode(
+    const vector<T> &sequence, EncodedSequence &encoded) const
+{
+    size_t bound = 0;
+
+    encoded.counts.resize(m_symbolCounts.size());
+
+    if (m_bitParallel)
+    {
+        encoded.bytes.resize(sequence.size());
+    }
+    else
+    {
+        encoded.codes.resize(sequence.size());
+    }
+
+    for (size_t i = 0; i < sequence.size(); ++i)
+    {
+        uint32_t code = m_codes.find(sequence[i]);
+
+        if (m_bitParallel)
+        {
+            encoded.bytes[i] = static_cast<uint8_t>(code);
+        }
+        else
+        {
+            encoded.codes[i] = code;
+        }
+
+        // Code 0 is never in the query, so never counts:
+        bound += encoded.counts[code] < m_symbolCounts[code];
+        ++encoded.counts[code];
+    }
+
+    // Clear the counts for the next sequence, touching only those set:
+    for (size_t i = 0; i < sequence.size(); ++i)
+    {
+        encoded.counts[m_bitParallel ? encoded.bytes[i] :
+                                       encoded.codes[i]] = 0;
+    }
+
+    return bound;
+}
+
+// Private Function: lengthOfEncoded
+// Inputs: encoded - A sequence rewritten by encode.
+// Output: The length of its longest common subsequence with the query.
+template <class T, class Hash>
+size_t LongestCommonSubsequenceSearch<T, Hash>::lengthOfEncoded(
+    const EncodedSequence &encoded) const
+{
+    if (m_bitParallel)
+    {
+        return m_bitParallel->length(encoded.bytes);
+    }
+
+    return findLongestCommonSubsequenceLength(m_queryCodes, encoded.codes);
+}
+
+// Private Function: searchCorpus
+// Inputs: search - The search this thread takes part in.
+// Output: None.
+// Compares the sequences of the corpus not yet taken by other threads with
+// the query, one at a time, then adds the best it found to the results.
+template <class T, class Hash>
+void LongestCommonSubsequenceSearch<T, Hash>::searchCorpus(
+    CorpusSearch &search) const
+{
+    EncodedSequence encoded;
+    size_t query = m_querySize, compared = 0;
+    // A heap with the least similar of the best found so far on top:
+    vector<SimilarSequence> best;
+
+    while (true)
+    {
+        size_t position = search.next++;
+
+        if (position >= search.order.size())
+        {
+            break;
+        }
+
+        size_t index = search.order[position];
+        const vector<T> &sequence = (*search.corpus)[index];
+        size_t threshold = search.threshold;
+
+        // No sequence after this one can reach the threshold either:
+        if (min(query, sequence.size()) < threshold)
+        {
+            break;
+        }
+
+        if (encode(sequence, encoded) < threshold)
+        {
+            continue;
+        }
+
+        SimilarSequence candidate = {index, lengthOfEncoded(encoded)};
+
+        ++compared;
+
+        if (best.size() < search.count)
+        {
+            best.push_back(candidate);
+            push_heap(best.begin(), best.end(), isMoreSimilar);
+        }
+        else if (isMoreSimilar(candidate, best.front()))
+        {
+            pop_heap(best.begin(), best.end(), isMoreSimilar);
+            best.back() = candidate;
+            push_heap(best.begin(), best.end(), isMoreSimilar);
+        }
+        else
+        {
+            continue;
+        }
+
+        // The results must be at least as good as this thread's best:
+        if (best.size() == search.count)
+        {
+            size_t reached = best.front().length;
+
+            while (threshold < reached &&
+                   !search.threshold.compare_exchange_weak(threshold,
+                                                           reached))
+            {
+            }
+        }
+    }
+
+    search.compared += compared;
+
+    lock_guard<mutex> lock(search.lock);
+    search.results.insert(search.results.end(), best.begin(), best.end());
+}
+
+#endif // LONGEST_COMMON_SUBSEQUENCE_SEARCH_H
@@ -0,0 +1,507 @@
+/* File: ParallelLongestCommonSubsequence.h
+ *
+ * This file contains findLongestCommonSubsequenceParallel, which finds the
+ * same longest common subsequence as the linear memory
+ * findLongestCommonSubsequence in LongestCommonSubsequence.h, using every
+ * thread of a ThreadPool.
+ *
+ * Each pass of Hirschberg's algorithm computes the dynamic programming table
+ * of a part of the whole table, from its last row and column up to its first.
+ * Here the part is cut into tiles of TILE_ROWS rows and TILE_COLUMNS columns,
+ * small enough for the rows a tile works on to stay in the processor's cache.
+ * A tile needs only the row of the table below it and the column to its
+ * right, so tiles on the same anti-diagonal can be computed at the same time,
+ * and every tile can start as soon as the tile below it and the tile to its
+ * right have finished. The tiles pass each other those boundaries through
+ * one buffer as wide as the table and one as tall as it: a tile reads its
+ * part of them and overwrites it with its own top row and left column, which
+ * are the boundaries the tiles above it and to its left need.
+ *
+ * The parts of the table left to solve shrink by half at each level of
+ * Hirschberg's recursion. A part too small to be cut into tiles is solved by
+ * the serial algorithm as a task of its own, at the same time as other small
+ * parts and the tiles of larger ones. Its subsequence is written straight
+ * into its place in the result, which is known because each pass also gives
+ * the lengths of the subsequences of both halves of the part.
+ *
+ * The memory used, besides the result, is O(n + m) for sequences of lengths
+ * n and m.
+ *
+ * Compile with -std=c++11 -pthread.
+ */
+
+#ifndef PARALLEL_LONGEST_COMMON_SUBSEQUENCE_H
+#define PARALLEL_LONGEST_COMMON_SUBSEQUENCE_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "LongestCommonSubsequence.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// The size of a tile. Its buffers take 32 bytes per column, so a tile row fits
+// in a 64 KB cache.
+const size_t TILE_ROWS = 512;
+const size_t TILE_COLUMNS = 2048;
+
+// Data Structure: ParallelSubsequenceSearch
+// What findLongestCommonSubsequenceParallel shares between all its passes
+// and tasks. As in LinearSubsequenceSearch, the rows are the elements of the
+// longer sequence.
+template <class T>
+struct ParallelSubsequenceSearch
+{
+    const vector<T> *rows;
+    const vector<T> *columns;
+    ThreadPool *pool;
+
+    // The boundaries between tiles, indexed by column and by row of the whole
+    // table. The crossings are relative to the first column of the part of
+    // the table being solved.
+    vector<size_t> rowLengths;
+    vector<size_t> rowCrossings;
+    vector<size_t> columnLengths;
+    vector<size_t> columnCrossings;
+
+    // The lengths of the middle row of the part being solved:
+    vector<size_t> middleLengths;
+
+    vector<T> *subsequence; // Sized once the first pass gives its length.
+};
+
+// Data Structure: TiledPass
+// One pass over a part of the table, cut into tiles. Tile row 0 is the top
+// one. The middle row of the part is the first row of a tile row, so that
+// every tile is either above it or not.
+template <class T>
+struct TiledPass
+{
+    ParallelSubsequenceSearch<T> *search;
+    size_t rowBegin;
+    size_t middleRow;
+    size_t columnBegin;
+    size_t columnEnd;
+    vector<size_t> tileRowBegins; // One more than the number of tile rows.
+    size_t tileColumns;
+
+    // For each tile row, the length and crossing at the cell diagonally
+    // below and to the right of the next tile to be computed in it:
+    vector<size_t> cornerLengths;
+    vector<size_t> cornerCrossings;
+
+    // For each tile, the number of its neighbours below and to the right
+    // that are still to finish:
+    unique_ptr<atomic<int>[]> waitingFor;
+
+    mutex lock;
+    condition_variable finished;
+    size_t tilesLeft;
+};
+
+// Function isWorthTiling
+//
+// Inputs: rows, columns - The size of a part of the table.
+//
+// Output: Returns true if the part can be cut into at least two tiles each
+//         way. Smaller parts are solved serially.
+inline bool isWorthTiling(size_t rows, size_t columns)
+{
+    return rows >= 2 * TILE_ROWS && columns >= 2 * TILE_COLUMNS;
+}
+
+// Function computeTile
+//
+// Inputs: pass - The pass the tile belongs to.
+//         tileRow, tileColumn - The position of the tile.
+//
+// Output: None. The boundaries in pass.search are replaced by the top row and
+//         left column of the tile.
+//
+// The same computation as one part of a pass of
+// appendLongestCommonSubsequence, see there.
+template <bool RowsAreSequence1, class T>
+void computeTile(TiledPass<T> &pass, size_t tileRow, size_t tileColumn)
+{
+    ParallelSubsequenceSearch<T> &search = *pass.search;
+    const T *rows = search.rows->data();
+    size_t rowBegin = pass.tileRowBegins[tileRow];
+    size_t rowEnd = pass.tileRowBegins[tileRow + 1];
+    size_t columnBegin = pass.columnBegin + tileColumn * TILE_COLUMNS;
+    size_t columnEnd = min(columnBegin + TILE_COLUMNS, pass.columnEnd);
+    size_t width = columnEnd - columnBegin;
+    const T *columns = search.columns->data() + columnBegin;
+    bool aboveMiddle = rowEnd <= pass.middleRow;
+    vector<size_t> lengthRows(2 * (width + 1));
+    vector<size_t> crossingRows(aboveMiddle ? 2 * (width + 1) : 0);
+    size_t *lengths = lengthRows.data();
+    size_t *below = lengths + width + 1;
+    size_t *crossings = crossingRows.data();
+    size_t *crossingsBelow = crossings + (aboveMiddle ? width + 1 : 0);
+
+    copy(search.rowLengths.begin() + columnBegin,
+         search.rowLengths.begin() + columnEnd, below);
+    below[width] = pass.cornerLengths[tileRow];
+
+    if (aboveMiddle)
+    {
+        copy(search.rowCrossings.begin() + columnBegin,
+             search.rowCrossings.begin() + columnEnd, crossingsBelow);
+        crossingsBelow[width] = pass.cornerCrossings[tileRow];
+    }
+
+    // The tile to the left needs the cell below this tile's first column,
+    // which this tile is about to overwrite:
+    pass.cornerLengths[tileRow] = search.rowLengths[columnBegin];
+    pass.cornerCrossings[tileRow] = search.rowCrossings[columnBegin];
+
+    if (rowEnd == pass.middleRow)
+    {
+        copy(below, below + width, search.middleLengths.begin() + columnBegin);
+    }
+
+    for (size_t row = rowEnd; row-- > rowBegin; )
+    {
+        lengths[width] = search.columnLengths[row];
+
+        if (!aboveMiddle)
+        {
+            for (size_t column = width; column-- > 0; )
+            {
+                size_t equal = elementsAreEqual<RowsAreSequence1>(
+                                   rows[row], columns[column]);
+
+                lengths[column] = max(max(below[column], lengths[column + 1]),
+                                      below[column + 1] + equal);
+            }
+        }
+        else
+        {
+            crossings[width] = search.columnCrossings[row];
+
+            for (size_t column = width; column-- > 0; )
+            {
+                size_t equal = elementsAreEqual<RowsAreSequence1>(
+                                   rows[row], columns[column]);
+                size_t down = below[column], right = lengths[column + 1];
+                size_t skipRow = RowsAreSequence1 ? down >= right :
+                                                    down > right;
+                size_t diagonalMask = 0 - equal, downMask = 0 - skipRow;
+                size_t skipCrossing = (crossingsBelow[column] & downMask) |
+                                      (crossings[column + 1] & ~downMask);
+
+                lengths[column] = max(max(down, right),
+                                      below[column + 1] + equal);
+                crossings[column] = (crossingsBelow[column + 1] &
+                                     diagonalMask) |
+                                    (skipCrossing & ~diagonalMask);
+            }
+
+            search.columnCrossings[row] = crossings[0];
+            swap(crossings, crossingsBelow);
+        }
+
+        search.columnLengths[row] = lengths[0];
+        swap(lengths, below);
+    }
+
+    copy(below, below + width, search.rowLengths.begin() + columnBegin);
+
+    if (aboveMiddle)
+    {
+        copy(crossingsBelow, crossingsBelow + width,
+             search.rowCrossings.begin() + columnBegin);
+    }
+}
+
+// Function runTile
+//
+// Inputs: pass - The pass the tile belongs to.
+//         tileRow, tileColumn - The position of the tile.
+//
+// Output: None.
+//
+// Computes the tile, then submits each neighbour above and to the left that
+// no longer waits for any other tile.
+template <bool RowsAreSequence1, class T>
+void runTile(TiledPass<T> &pass, size_t tileRow, size_t tileColumn)
+{
+    computeTile<RowsAreSequence1>(pass, tileRow, tileColumn);
+
+    TiledPass<T> *passPointer = &pass;
+
+    if (tileRow > 0 &&
+        --pass.waitingFor[(tileRow - 1) * pass.tileColumns + tileColumn] == 0)
+    {
+        pass.search->pool->submit([passPointer, tileRow, tileColumn]()
+        {
+            runTile<RowsAreSequence1>(*passPointer, tileRow - 1, tileColumn);
+        });
+    }
+
+    if (tileColumn > 0 &&
+        --pass.waitingFor[tileRow * pass.tileColumns + tileColumn - 1] == 0)
+    {
+        pass.search->pool->submit([passPointer, tileRow, tileColumn]()
+        {
+            runTile<RowsAreSequence1>(*passPointer, tileRow, tileColumn - 1);
+        });
+    }
+
+    lock_guard<mutex> lock(pass.lock);
+
+    if (--pass.tilesLeft == 0)
+    {
+        pass.finished.notify_one();
+    }
+}
+
+// Function runTiledPass
+//
+// Inputs: search - The search the pass is part of.
+//         rowBegin, rowEnd - The rows [rowBegin, rowEnd) of the part of the
+//                            table, at least two.
+//         columnBegin, columnEnd - Its columns [columnBegin, columnEnd).
+//         middleRow - The row at which the part is split in two.
+//         middleColumn - Set to the column at which the subsequence of the
+//                        part reaches the middle row.
+//         length - Set to the length of the subsequence of the part.
+//         lowerLength - Set to the length of its subsequence from the middle
+//                       row on.
+//
+// Output: None.
+//
+// Returns once every tile has been computed.
+template <bool RowsAreSequence1, class T>
+void runTiledPass(ParallelSubsequenceSearch<T> &search,
+                  size_t rowBegin, size_t rowEnd,
+                  size_t columnBegin, size_t columnEnd, size_t middleRow,
+                  size_t &middleColumn, size_t &length, size_t &lowerLength)
+{
+    TiledPass<T> pass;
+    size_t width = columnEnd - columnBegin;
+
+    pass.search = &search;
+    pass.rowBegin = rowBegin;
+    pass.middleRow = middleRow;
+    pass.columnBegin = columnBegin;
+    pass.columnEnd = columnEnd;
+    pass.tileColumns = (width + TILE_COLUMNS - 1) / TILE_COLUMNS;
+
+    for (size_t row = rowBegin; row < middleRow; row += TILE_ROWS)
+    {
+        pass.tileRowBegins.push_back(row);
+    }
+
+    for (size_t row = middleRow; row < rowEnd; row += TILE_ROWS)
+    {
+        pass.tileRowBegins.push_back(row);
+    }
+
+    pass.tileRowBegins.push_back(rowEnd);
+
+    size_t tileRows = pass.tileRowBegins.size() - 1;
+
+    // Past the last row and column the lengths are zero, and a walk from the
+    // middle row is already there:
+    for (size_t column = columnBegin; column < columnEnd; ++column)
+    {
+        search.rowLengths[column] = 0;
+        search.rowCrossings[column] = column - columnBegin;
+    }
+
+    for (size_t row = rowBegin; row < rowEnd; ++row)
+    {
+        search.columnLengths[row] = 0;
+        search.columnCrossings[row] = width;
+    }
+
+    search.middleLengths[columnEnd] = 0;
+    pass.cornerLengths.assign(tileRows, 0);
+    pass.cornerCrossings.assign(tileRows, width);
+    pass.waitingFor.reset(new atomic<int>[tileRows * pass.tileColumns]);
+    pass.tilesLeft = tileRows * pass.tileColumns;
+
+    for (size_t tileRow = 0; tileRow < tileRows; ++tileRow)
+    {
+        for (size_t tileColumn = 0; tileColumn < pass.tileColumns;
+             ++tileColumn)
+        {
+            pass.waitingFor[tileRow * pass.tileColumns + tileColumn] =
+                (tileRow + 1 < tileRows) + (tileColumn + 1 < pass.tileColumns);
+        }
+    }
+
+    TiledPass<T> *passPointer = &pass;
+    size_t lastRow = tileRows - 1, lastColumn = pass.tileColumns - 1;
+
+    search.pool->submit([passPointer, lastRow, lastColumn]()
+    {
+        runTile<RowsAreSequence1>(*passPointer, lastRow, lastColumn);
+    });
+
+    unique_lock<mutex> lock(pass.lock);
+
+    while (pass.tilesLeft > 0)
+    {
+        pass.finished.wait(lock);
+    }
+
+    middleColumn = columnBegin + search.rowCrossings[columnBegin];
+    length = search.rowLengths[columnBegin];
+    lowerLength = search.middleLengths[middleColumn];
+}
+
+// Function solvePartSerially
+//
+// Inputs: search - The search the part belongs to.
+//         rowBegin, rowEnd, columnBegin, columnEnd - The part of the table.
+//         position - The index in search.subsequence of the first element
+//                    of the subsequence of the part.
+//
+// Output: None.
+//
+// Runs on a thread of the pool.
+template <bool RowsAreSequence1, class T>
+void solvePartSerially(ParallelSubsequenceSearch<T> &search,
+                       size_t rowBegin, size_t rowEnd,
+                       size_t columnBegin, size_t columnEnd, size_t position)
+{
+    LinearSubsequenceSearch<T> part;
+    vector<T> subsequence;
+    size_t width = columnEnd - columnBegin;
+
+    part.rows = search.rows;
+    part.columns = search.columns;
+    part.lengths.resize(width + 1);
+    part.below.resize(width + 1);
+    part.crossings.resize(width + 1);
+    part.crossingsBelow.resize(width + 1);
+    part.subsequence = &subsequence;
+
+    appendLongestCommonSubsequence<RowsAreSequence1>(part, rowBegin, rowEnd,
+                                                     columnBegin, columnEnd);
+
+    copy(subsequence.begin(), subsequence.end(),
+         search.subsequence->begin() + position);
+}
+
+// Function placeLongestCommonSubsequence
+//
+// Inputs: search - The search the part belongs to.
+//         rowBegin, rowEnd, columnBegin, columnEnd - The part of the table.
+//         position - The index in search.subsequence of the first element
+//                    of the subsequence of the part.
+//
+// Output: None.
+//
+// Splits the part with a tiled pass, or hands it to the pool to be solved
+// serially if it is too small to be cut into at least two tiles each way.
+template <bool RowsAreSequence1, class T>
+void placeLongestCommonSubsequence(ParallelSubsequenceSearch<T> &search,
+                                   size_t rowBegin, size_t rowEnd,
+                                   size_t columnBegin, size_t columnEnd,
+                                   size_t position)
+{
+    if (rowBegin == rowEnd || columnBegin == columnEnd)
+    {
+        return;
+    }
+
+    if (!isWorthTiling(rowEnd - rowBegin, columnEnd - columnBegin))
+    {
+        ParallelSubsequenceSearch<T> *searchPointer = &search;
+
+        search.pool->submit([=]()
+        {
+            solvePartSerially<RowsAreSequence1>(*searchPointer,
+                rowBegin, rowEnd, columnBegin, columnEnd, position);
+        });
+
+        return;
+    }
+
+    size_t middleRow = rowBegin + (rowEnd - rowBegin) / 2;
+    size_t middleColumn, length, lowerLength;
+
+    runTiledPass<RowsAreSequence1>(search, rowBegin, rowEnd,
+                                   columnBegin, columnEnd, middleRow,
+                                   middleColumn, length, lowerLength);
+
+    // The whole table is solved first, and its length sizes the result:
+    if (rowBegin == 0 && rowEnd == search.rows->size() &&
+        columnBegin == 0 && columnEnd == search.columns->size())
+    {
+        search.subsequence->resize(length);
+    }
+
+    placeLongestCommonSubsequence<RowsAreSequence1>(search,
+        rowBegin, middleRow, columnBegin, middleColumn, position);
+    placeLongestCommonSubsequence<RowsAreSequence1>(search,
+        middleRow, rowEnd, middleColumn, columnEnd,
+        position + length - lowerLength);
+}
+
+// Function findLongestCommonSubsequenceParallel
+//
+// Inputs: sequence1 - The first of two sequences used in searching for the
+//                     longest common subsequence between them.
+//         sequence2 - The second of two sequences used in searching for the
+//                     longest common subsequence between them.
+//         pool - The threads to use. The calling thread only waits.
+//
+// Output: A vector containing the longest common subsequence of the two input
+//          sequences, the same one findLongestCommonSubsequence returns.
+//
+// Sequences too short to be cut into tiles are compared by
+// findLongestCommonSubsequence on the calling thread. Besides the
+// requirements of findLongestCommonSubsequence, T must have a default
+// constructor, since the result is made at its full size before its parts
+// are filled in.
+template <class T>
+vector<T> findLongestCommonSubsequenceParallel(const vector<T> &sequence1,
+                                               const vector<T> &sequence2,
+                                               ThreadPool &pool)
+{
+    ParallelSubsequenceSearch<T> search;
+    vector<T> subsequence;
+    bool rowsAreSequence1 = sequence1.size() >= sequence2.size();
+
+    search.rows = rowsAreSequence1 ? &sequence1 : &sequence2;
+    search.columns = rowsAreSequence1 ? &sequence2 : &sequence1;
+
+    if (!isWorthTiling(search.rows->size(), search.columns->size()))
+    {
+        return findLongestCommonSubsequence(sequence1, sequence2);
+    }
+
+    search.pool = &pool;
+    search.rowLengths.resize(search.columns->size() + 1);
+    search.rowCrossings.resize(search.columns->size() + 1);
+    search.columnLengths.resize(search.rows->size() + 1);
+    search.columnCrossings.resize(search.rows->size() + 1);
+    search.middleLengths.resize(search.columns->size() + 1);
+    search.subsequence = &subsequence;
+
+    if (rowsAreSequence1)
+    {
+        placeLongestCommonSubsequence<true>(search, 0, search.rows->size(),
+                                            0, search.columns->size(), 0);
+    }
+    else
+    {
+        placeLongestCommonSubsequence<false>(search, 0, search.rows->size(),
+                                             0, search.columns->size(), 0);
+    }
+
+    pool.wait();
+
+    return subsequence;
+}
+
+#endif // PARALLEL_LONGEST_COMMON_SUBSEQUENCE_H
@@ -0,0 +1,315 @@
+/* File: SparseLongestCommonSubsequence.h
+ *
+ * This file contains findLongestCommonSubsequenceSparse, a version of the
+ * Hunt-Szymanski algorithm that finds the same longest common subsequence as
+ * findLongestCommonSubsequence in LongestCommonSubsequence.h, and
+ * findLongestCommonSubsequenceAdaptive, which picks whichever of the two
+ * should be faster for the sequences it is given.
+ *
+ * The dynamic programming table has a cell for every pair of elements, but
+ * only the cells of matching pairs, equal elements, ever add to a common
+ * subsequence. When the sequences have many different elements, such as
+ * hashes or identifiers, few pairs match and nearly all the work of filling
+ * the table is wasted. Hunt-Szymanski instead lists, for every element of
+ * sequence2, the positions where it occurs, and visits only the r matching
+ * pairs, in O((r + n) log n) time for sequences of length n.
+ *
+ * The pairs are visited from the last element of sequence1 to the first. For
+ * each k the algorithm keeps the largest position j in sequence2 such that a
+ * common subsequence of length k starts at or after j in the part of the
+ * sequences seen so far. These positions decrease with k, so a binary search
+ * gives the length of the longest common subsequence that starts with each
+ * matching pair, called its level.
+ *
+ * The subsequence is then found by the same walk the dense algorithm makes
+ * through the table: from the first cell, equal elements are taken, and
+ * otherwise the walk skips the element of sequence1 if that still leaves a
+ * subsequence as long as the one it is looking for. That is the case exactly
+ * when a matching pair of the level the walk is looking for lies below and
+ * not to the left of it. The pairs of one level form a staircase, going down
+ * as they go left, so it is enough to know, for every position in sequence2,
+ * the lowest pair of the level there. The walk moves through each level from
+ * left to right, so its steps cost O(1) each.
+ *
+ * The levels take O(r) memory.
+ *
+ * Compile with -std=c++11.
+ */
+
+#ifndef SPARSE_LONGEST_COMMON_SUBSEQUENCE_H
+#define SPARSE_LONGEST_COMMON_SUBSEQUENCE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "LongestCommonSubsequence.h"
+
+using namespace std;
+
+// Data Structure: SparseMatchIndex
+// The positions at which each element occurs in a sequence, in increasing
+// order.
+template <class T, class Hash = hash<T> >
+struct SparseMatchIndex
+{
+    unordered_map<T, vector<size_t>, Hash> positions;
+};
+
+// Data Structure: LongestCommonSubsequenceEngine
+// The algorithms findLongestCommonSubsequenceAdaptive chooses between.
+enum LongestCommonSubsequenceEngine
+{
+    DENSE_ENGINE,  // findLongestCommonSubsequence(sequence1, sequence2).
+    SPARSE_ENGINE  // findLongestCommonSubsequenceSparse.
+};
+
+// Function buildSparseMatchIndex
+//
+// Inputs: sequence - The sequence to index.
+//         index - Filled with the positions of each element of sequence.
+//
+// Output: None.
+template <class T, class Hash>
+void buildSparseMatchIndex(const vector<T> &sequence,
+                           SparseMatchIndex<T, Hash> &index)
+{
+    index.positions.clear();
+
+    for (size_t position = 0; position < sequence.size(); ++position)
+    {
+        index.positions[sequence[position]].push_back(position);
+    }
+}
+
+// Function countMatchingPairs
+//
+// Inputs: sequence1 - A sequence.
+//         index - The index of another sequence.
+//
+// Output: Returns the number of pairs of an element of sequence1 and an equal
+//         element of the other sequence.
+template <class T, class Hash>
+size_t countMatchingPairs(const vector<T> &sequence1,
+                          const SparseMatchIndex<T, Hash> &index)
+{
+    size_t pairs = 0;
+
+    for (size_t i = 0; i < sequence1.size(); ++i)
+    {
+        typename unordered_map<T, vector<size_t>, Hash>::const_iterator found =
+            index.positions.find(sequence1[i]);
+
+        if (found != index.positions.end())
+        {
+            pairs += found->second.size();
+        }
+    }
+
+    return pairs;
+}
+
+// Function selectLongestCommonSubsequenceEngine
+//
+// Inputs: size1, size2 - The lengths of two sequences.
+//         matchingPairs - The number of pairs of equal elements, one from
+//                         each sequence.
+//
+// Output: Returns the engine expected to find their longest common
+//         subsequence faster.
+//
+// The dense engine visits each cell of the table about twice; the sparse one
+// does a binary search for each matching pair and for each element of
+// sequence1. The weights are the measured costs of one step of each, so the
+// sparse engine wins unless the table is more than a few percent matches.
+inline LongestCommonSubsequenceEngine selectLongestCommonSubsequenceEngine(
+    size_t size1, size_t size2, size_t matchingPairs)
+{
+    const double DENSE_CELL_COST = 7.0;
+    const double SPARSE_STEP_COST = 10.0;
+
+    double denseCost = DENSE_CELL_COST * size1 * size2;
+    double sparseCost = SPARSE_STEP_COST * (matchingPairs + size1) *
+                        log2(2.0 + min(size1, size2));
+
+    return sparseCost < denseCost ? SPARSE_ENGINE : DENSE_ENGINE;
+}
+
+// Function findLongestCommonSubsequenceSparse
+//
+// Inputs: sequence1 - The first of two sequences used in searching for the
+//                     longest common subsequence between them.
+//         index - The index of the second sequence, made by
+//                 buildSparseMatchIndex.
+//         sequence2 - The second sequence.
+//
+// Output: A vector containing the longest common subsequence of the two input
+//          sequences, the same one findLongestCommonSubsequence returns.
+//
+// See the description at the top of the file.
+template <class T, class Hash>
+vector<T> findLongestCommonSubsequenceSparse(
+    const vector<T> &sequence1, const SparseMatchIndex<T, Hash> &index,
+    const vector<T> &sequence2)
+{
+    // starts[k - 1] is the largest position in sequence2 at which a common
+    // subsequence of length k of the elements seen so far starts:
+    vector<size_t> starts;
+    // levels[k - 1] holds a (position in sequence2, position in sequence1)
+    // pair for every matching pair of level k:
+    vector<vector<pair<size_t, size_t> > > levels;
+    vector<T> subsequence;
+
+    for (size_t i = sequence1.size(); i-- > 0; )
+    {
+        typename unordered_map<T, vector<size_t>, Hash>::const_iterator found =
+            index.positions.find(sequence1[i]);
+
+        if (found == index.positions.end())
+        {
+            continue;
+        }
+
+        // In increasing order, so that a pair cannot extend a subsequence
+        // that starts with another pair of the same element of sequence1:
+        const vector<size_t> &positions = found->second;
+
+        for (size_t p = 0; p < positions.size(); ++p)
+        {
+            size_t j = positions[p];
+            size_t level = lower_bound(starts.begin(), starts.end(), j,
+                                       greater<size_t>()) - starts.begin();
+
+            if (level == starts.size())
+            {
+                starts.push_back(j);
+                levels.push_back(vector<pair<size_t, size_t> >());
+            }
+            else
+            {
+                starts[level] = j;
+            }
+
+            levels[level].push_back(make_pair(j, i));
+        }
+    }
+
+    // Keep the lowest pair at each position of each level. The pairs were
+    // added from the bottom up, so after a stable sort by position the first
+    // pair at each position is the lowest:
+    for (size_t level = 0; level < levels.size(); ++level)
+    {
+        vector<pair<size_t, size_t> > &pairs = levels[level];
+        size_t kept = 0;
+
+        stable_sort(pairs.begin(), pairs.end(),
+                    [](const pair<size_t, size_t> &a,
+                       const pair<size_t, size_t> &b)
+                    {
+                        return a.first < b.first;
+                    });
+
+        for (size_t p = 0; p < pairs.size(); ++p)
+        {
+            if (kept == 0 || pairs[kept - 1].first != pairs[p].first)
+            {
+                pairs[kept++] = pairs[p];
+            }
+        }
+
+        pairs.resize(kept);
+    }
+
+    size_t remaining = levels.size(), i = 0, j = 0, next = 0;
+
+    subsequence.reserve(remaining);
+
+    while (remaining > 0)
+    {
+        if (sequence1[i] == sequence2[j])
+        {
+            subsequence.push_back(sequence1[i]);
+            ++i;
+            ++j;
+            next = 0;
+            --remaining;
+            continue;
+        }
+
+        // The first pair of the level at or to the right of the walk is the
+        // lowest one there:
+        const vector<pair<size_t, size_t> > &pairs = levels[remaining - 1];
+
+        while (pairs[next].first < j)
+        {
+            ++next;
+        }
+
+        if (pairs[next].second > i)
+        {
+            ++i;
+        }
+        else
+        {
+            ++j;
+        }
+    }
+
+    return subsequence;
+}
+
+// Function findLongestCommonSubsequenceSparse
+//
+// Inputs: sequence1, sequence2 - The two sequences.
+//
+// Output: A vector containing the longest common subsequence of the two input
+//          sequences, the same one findLongestCommonSubsequence returns.
+//
+// Besides equality, T must have a hash function, std::hash<T>.
+template <class T>
+vector<T> findLongestCommonSubsequenceSparse(const vector<T> &sequence1,
+                                             const vector<T> &sequence2)
+{
+    SparseMatchIndex<T> index;
+
+    buildSparseMatchIndex(sequence2, index);
+
+    return findLongestCommonSubsequenceSparse(sequence1, index, sequence2);
+}
+
+// Function findLongestCommonSubsequenceAdaptive
+//
+// Inputs: sequence1, sequence2 - The two sequences.
+//
+// Output: A vector containing the longest common subsequence of the two input
+//          sequences, the same one findLongestCommonSubsequence returns.
+//
+// Indexes sequence2 and counts the matching pairs, which takes O(n + m)
+// time, then runs the sparse engine if selectLongestCommonSubsequenceEngine
+// expects it to be faster, and the dense one otherwise. T must have a hash
+// function, std::hash<T>.
+template <class T>
+vector<T> findLongestCommonSubsequenceAdaptive(const vector<T> &sequence1,
+                                               const vector<T> &sequence2)
+{
+    SparseMatchIndex<T> index;
+
+    buildSparseMatchIndex(sequence2, index);
+
+    size_t pairs = countMatchingPairs(sequence1, index);
+
+    if (selectLongestCommonSubsequenceEngine(sequence1.size(),
+                                             sequence2.size(), pairs) ==
+        SPARSE_ENGINE)
+    {
+        return findLongestCommonSubsequenceSparse(sequence1, index,
+                                                  sequence2);
+    }
+
+    return findLongestCommonSubsequence(sequence1, sequence2);
+}
+
+#endif // SPARSE_LONGEST_COMMON_SUBSEQUENCE_H
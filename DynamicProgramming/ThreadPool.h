@@ -0,0 +1,174 @@
+/* File: ThreadPool.h
+ *
+ * This file contains the ThreadPool class, a fixed set of worker threads that
+ * run tasks taken from a shared queue in the order they were submitted.
+ * Starting a thread costs far more than running a small task, so algorithms
+ * that split their work into many tasks keep one pool and reuse its threads.
+ *
+ * A task may submit further tasks. wait() returns once every task submitted
+ * so far, including those submitted by other tasks, has finished, so a task
+ * must not call wait() itself.
+ *
+ * Compile with -std=c++11 -pthread.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Data Structure: ThreadPool
+class ThreadPool
+{
+    public:
+        explicit ThreadPool(size_t threadCount = 0);
+        ~ThreadPool();
+
+        size_t size() const;
+        void submit(const function<void()> &task);
+        void wait();
+
+    private:
+        // The threads cannot be shared by two pools:
+        ThreadPool(const ThreadPool &);
+        ThreadPool &operator=(const ThreadPool &);
+
+        void work();
+
+        vector<thread> m_threads;
+        mutex m_lock;
+        condition_variable m_taskReady; // Signalled when a task is queued.
+        condition_variable m_allDone;   // Signalled when m_unfinished is 0.
+        deque<function<void()> > m_tasks;
+        size_t m_unfinished; // Tasks queued or running.
+        bool m_stopping;
+};
+
+
+////
+//// Public Functions:
+////
+
+// Public Function: ThreadPool
+// Inputs: threadCount - The number of worker threads, or 0 for one per
+//                       hardware thread.
+// Output: None.
+inline ThreadPool::ThreadPool(size_t threadCount)
+    : m_unfinished(0), m_stopping(false)
+{
+    if (threadCount == 0)
+    {
+        threadCount = thread::hardware_concurrency();
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        m_threads.push_back(thread(&ThreadPool::work, this));
+    }
+}
+
+// Finishes the tasks already queued, then stops the threads:
+inline ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_stopping = true;
+    }
+
+    m_taskReady.notify_all();
+
+    for (size_t i = 0; i < m_threads.size(); ++i)
+    {
+        m_threads[i].join();
+    }
+}
+
+// Public Function: size
+// Inputs: None.
+// Output: The number of worker threads.
+inline size_t ThreadPool::size() const
+{
+    return m_threads.size();
+}
+
+// Public Function: submit
+// Inputs: task - The function to run on one of the threads.
+// Output: None.
+inline void ThreadPool::submit(const function<void()> &task)
+{
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_tasks.push_back(task);
+        ++m_unfinished;
+    }
+
+    m_taskReady.notify_one();
+}
+
+// Public Function: wait
+// Inputs: None.
+// Output: None.
+// Returns once no task is queued or running.
+inline void ThreadPool::wait()
+{
+    unique_lock<mutex> lock(m_lock);
+
+    while (m_unfinished > 0)
+    {
+        m_allDone.wait(lock);
+    }
+}
+
+
+////
+//// Private functions:
+////
+
+// Private Function: work
+// Inputs: None.
+// Output: None.
+// The loop each worker thread runs until the pool is destroyed.
+inline void ThreadPool::work()
+{
+    unique_lock<mutex> lock(m_lock);
+
+    while (true)
+    {
+        while (m_tasks.empty() && !m_stopping)
+        {
+            m_taskReady.wait(lock);
+        }
+
+        if (m_tasks.empty())
+        {
+            return;
+        }
+
+        function<void()> task = m_tasks.front();
+
+        m_tasks.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+
+        if (--m_unfinished == 0)
+        {
+            m_allDone.notify_all();
+        }
+    }
+}
+
+#endif // THREAD_POOL_H